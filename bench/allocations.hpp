@@ -0,0 +1,24 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef WINTLS_BENCH_ALLOCATIONS_HPP
+#define WINTLS_BENCH_ALLOCATIONS_HPP
+
+#include <cstddef>
+
+// Snapshot of the allocations done through the global operator new
+// which is replaced by the benchmark executable, combined with the
+// private bytes of the process for catching allocations done by
+// Windows itself (e.g. by the CryptoAPI functions).
+struct allocation_snapshot {
+  std::size_t count;
+  std::size_t bytes;
+  std::size_t private_bytes;
+};
+
+allocation_snapshot current_allocations();
+
+#endif // WINTLS_BENCH_ALLOCATIONS_HPP
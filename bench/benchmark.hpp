@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef WINTLS_BENCH_BENCHMARK_HPP
+#define WINTLS_BENCH_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+// Records individual operation latencies for calculating percentiles
+class latency_recorder {
+public:
+  void reserve(std::size_t count) {
+    samples_.reserve(count);
+  }
+
+  void record(bench_clock::duration latency) {
+    samples_.push_back(latency);
+    sorted_ = false;
+  }
+
+  std::size_t count() const {
+    return samples_.size();
+  }
+
+  void merge(const latency_recorder& other) {
+    samples_.insert(samples_.end(), other.samples_.begin(), other.samples_.end());
+    sorted_ = false;
+  }
+
+  // Percentile in the range [0, 100]
+  bench_clock::duration percentile(double p) {
+    if (samples_.empty()) {
+      return {};
+    }
+    if (!sorted_) {
+      std::sort(samples_.begin(), samples_.end());
+      sorted_ = true;
+    }
+    const auto rank = static_cast<std::size_t>(p / 100.0 * static_cast<double>(samples_.size() - 1) + 0.5);
+    return samples_[std::min(rank, samples_.size() - 1)];
+  }
+
+private:
+  std::vector<bench_clock::duration> samples_;
+  bool sorted_ = false;
+};
+
+struct benchmark_result {
+  std::string name;
+  std::size_t operations = 0;
+  std::size_t bytes = 0;
+  bench_clock::duration elapsed{};
+  // Only reported when tracking allocations, see allocations.hpp
+  bool has_allocations = false;
+  std::size_t allocations = 0;
+  std::size_t allocated_bytes = 0;
+  std::ptrdiff_t private_bytes_delta = 0;
+};
+
+inline double to_microseconds(bench_clock::duration d) {
+  return std::chrono::duration<double, std::micro>(d).count();
+}
+
+// Prints a benchmark result as a single line of space separated
+// key=value pairs, which is what bench/report.py consumes.
+inline void report(const benchmark_result& result, latency_recorder* latencies = nullptr) {
+  const double seconds = std::chrono::duration<double>(result.elapsed).count();
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(2);
+  oss << "BENCHMARK name=" << result.name
+      << " ops=" << result.operations
+      << " seconds=" << seconds
+      << " ops_per_second=" << (seconds > 0 ? static_cast<double>(result.operations) / seconds : 0.0)
+      << " mib_per_second=" << (seconds > 0 ? static_cast<double>(result.bytes) / seconds / 0x100000 : 0.0);
+  if (latencies != nullptr && latencies->count() > 0) {
+    oss << " p50_us=" << to_microseconds(latencies->percentile(50))
+        << " p90_us=" << to_microseconds(latencies->percentile(90))
+        << " p99_us=" << to_microseconds(latencies->percentile(99))
+        << " p999_us=" << to_microseconds(latencies->percentile(99.9))
+        << " max_us=" << to_microseconds(latencies->percentile(100));
+  }
+  if (result.has_allocations) {
+    oss << " allocations=" << result.allocations
+        << " allocated_bytes=" << result.allocated_bytes
+        << " private_bytes_delta=" << result.private_bytes_delta;
+  }
+  std::cout << oss.str() << std::endl;
+}
+
+inline std::string generate_data(std::size_t size) {
+  std::string ret(size, '\0');
+  for (std::size_t i = 0; i < size; ++i) {
+    ret[i] = static_cast<char>(i % 26 + 65);
+  }
+  return ret;
+}
+
+inline std::string size_name(std::size_t size) {
+  if (size >= 0x100000 && size % 0x100000 == 0) {
+    return std::to_string(size / 0x100000) + "MiB";
+  }
+  if (size >= 0x400 && size % 0x400 == 0) {
+    return std::to_string(size / 0x400) + "KiB";
+  }
+  return std::to_string(size) + "B";
+}
+
+#endif // WINTLS_BENCH_BENCHMARK_HPP
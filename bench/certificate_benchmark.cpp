@@ -0,0 +1,251 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Benchmarks of the certificate loading done at startup by servers
+// hosting a large number of certificates.
+
+#include "allocations.hpp"
+#include "benchmark.hpp"
+
+#include "certificate.hpp"
+#include "unittest.hpp"
+
+#include <wintls.hpp>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const std::size_t max_certificates = 10000;
+
+struct bio_deleter {
+  void operator()(BIO* bio) {
+    BIO_free(bio);
+  }
+};
+
+struct evp_pkey_deleter {
+  void operator()(EVP_PKEY* key) {
+    EVP_PKEY_free(key);
+  }
+};
+
+struct x509_deleter {
+  void operator()(X509* cert) {
+    X509_free(cert);
+  }
+};
+
+struct x509_crl_deleter {
+  void operator()(X509_CRL* crl) {
+    X509_CRL_free(crl);
+  }
+};
+
+struct crl_ctx_deleter {
+  void operator()(const CRL_CONTEXT* crl_ctx) {
+    CertFreeCRLContext(crl_ctx);
+  }
+};
+
+using bio_ptr = std::unique_ptr<BIO, bio_deleter>;
+using evp_pkey_ptr = std::unique_ptr<EVP_PKEY, evp_pkey_deleter>;
+using x509_ptr = std::unique_ptr<X509, x509_deleter>;
+using x509_crl_ptr = std::unique_ptr<X509_CRL, x509_crl_deleter>;
+using crl_ctx_ptr = std::unique_ptr<const CRL_CONTEXT, crl_ctx_deleter>;
+
+std::string bio_to_string(BIO* bio) {
+  char* data = nullptr;
+  const auto size = BIO_get_mem_data(bio, &data);
+  return std::string(data, static_cast<std::size_t>(size));
+}
+
+// A self signed certificate authority in PEM format together with an
+// empty CRL issued by it
+struct generated_certificate {
+  std::string certificate;
+  std::string crl;
+};
+
+// Generates distinct certificates all using the test key, making it
+// possible to use any of them as server certificate with the imported
+// test key.
+std::vector<generated_certificate> generate_certificates(std::size_t count) {
+  bio_ptr key_bio{BIO_new_mem_buf(test_key.data(), static_cast<int>(test_key.size()))};
+  evp_pkey_ptr key{PEM_read_bio_PrivateKey(key_bio.get(), nullptr, nullptr, nullptr)};
+  REQUIRE(key);
+
+  std::vector<generated_certificate> ret;
+  ret.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto common_name = "wintls-benchmark-" + std::to_string(i);
+
+    x509_ptr cert{X509_new()};
+    X509_set_version(cert.get(), 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), static_cast<long>(i + 1));
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), 60L * 60 * 24 * 365);
+    X509_set_pubkey(cert.get(), key.get());
+    auto name = X509_get_subject_name(cert.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char*>(common_name.c_str()), -1, -1, 0);
+    X509_set_issuer_name(cert.get(), name);
+    REQUIRE(X509_sign(cert.get(), key.get(), EVP_sha256()) > 0);
+
+    x509_crl_ptr crl{X509_CRL_new()};
+    X509_CRL_set_version(crl.get(), 1);
+    X509_CRL_set_issuer_name(crl.get(), name);
+    X509_CRL_set1_lastUpdate(crl.get(), X509_get0_notBefore(cert.get()));
+    X509_CRL_set1_nextUpdate(crl.get(), X509_get0_notAfter(cert.get()));
+    REQUIRE(X509_CRL_sign(crl.get(), key.get(), EVP_sha256()) > 0);
+
+    bio_ptr cert_bio{BIO_new(BIO_s_mem())};
+    PEM_write_bio_X509(cert_bio.get(), cert.get());
+    bio_ptr crl_bio{BIO_new(BIO_s_mem())};
+    PEM_write_bio_X509_CRL(crl_bio.get(), crl.get());
+    ret.push_back({bio_to_string(cert_bio.get()), bio_to_string(crl_bio.get())});
+  }
+  return ret;
+}
+
+// Generating thousands of signed certificates takes a while, so only
+// do it once and let each benchmark use as many as it needs
+const std::vector<generated_certificate>& certificates() {
+  static const auto certs = generate_certificates(max_certificates);
+  return certs;
+}
+
+std::vector<wintls::cert_context_ptr> cert_contexts(std::size_t count) {
+  std::vector<wintls::cert_context_ptr> ret;
+  ret.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    ret.push_back(wintls::x509_to_cert_context(net::buffer(certificates()[i].certificate), wintls::file_format::pem));
+  }
+  return ret;
+}
+
+std::string key_name(std::size_t index) {
+  return "wintls-benchmark-key-" + std::to_string(index);
+}
+
+// Runs the function once, reporting the time spent and the memory
+// allocated while doing so as a benchmark result
+template <typename Function>
+void measure(const std::string& name, std::size_t count, Function&& function) {
+  const auto allocations_before = current_allocations();
+  const auto start = bench_clock::now();
+  std::forward<Function>(function)();
+  const auto elapsed = bench_clock::now() - start;
+  const auto allocations_after = current_allocations();
+
+  benchmark_result result;
+  result.name = "certificate/" + name + "/" + std::to_string(count);
+  result.operations = count;
+  result.elapsed = elapsed;
+  result.has_allocations = true;
+  result.allocations = allocations_after.count - allocations_before.count;
+  result.allocated_bytes = allocations_after.bytes - allocations_before.bytes;
+  result.private_bytes_delta = static_cast<std::ptrdiff_t>(allocations_after.private_bytes) -
+                               static_cast<std::ptrdiff_t>(allocations_before.private_bytes);
+  report(result);
+}
+
+} // namespace
+
+TEST_CASE("certificate loading", "[certificate]") {
+  const auto count = GENERATE(as<std::size_t>{}, 1, 100, max_certificates);
+  REQUIRE(certificates().size() >= count);
+
+  SECTION("x509_to_cert_context") {
+    std::vector<wintls::cert_context_ptr> contexts;
+    contexts.reserve(count);
+    measure("x509_to_cert_context", count, [&]() {
+      for (std::size_t i = 0; i < count; ++i) {
+        contexts.push_back(wintls::x509_to_cert_context(net::buffer(certificates()[i].certificate),
+                                                        wintls::file_format::pem));
+      }
+    });
+    CHECK(contexts.size() == count);
+  }
+
+  SECTION("add_certificate_authority") {
+    const auto contexts = cert_contexts(count);
+    wintls::context ctx{wintls::method::system_default};
+    measure("add_certificate_authority", count, [&]() {
+      for (const auto& cert : contexts) {
+        ctx.add_certificate_authority(cert.get());
+      }
+    });
+  }
+
+  SECTION("add_certificate_authority with crls") {
+    const auto contexts = cert_contexts(count);
+    std::vector<crl_ctx_ptr> crls;
+    crls.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto data = wintls::detail::crypt_string_to_binary(net::buffer(certificates()[i].crl));
+      crls.emplace_back(CertCreateCRLContext(X509_ASN_ENCODING, data.data(), static_cast<DWORD>(data.size())));
+      REQUIRE(crls.back());
+    }
+    // The context doesn't expose adding CRLs so use the certificate
+    // store it wraps directly
+    wintls::detail::context_certificates ctx_certs;
+    measure("add_certificate_authority_with_crl", count, [&]() {
+      for (std::size_t i = 0; i < count; ++i) {
+        ctx_certs.add_certificate_authority(contexts[i].get());
+        ctx_certs.add_crl(crls[i].get());
+      }
+    });
+  }
+
+  SECTION("import_private_key") {
+    measure("import_private_key", count, [&]() {
+      for (std::size_t i = 0; i < count; ++i) {
+        wintls::import_private_key(net::buffer(test_key), wintls::file_format::pem, key_name(i));
+      }
+    });
+    for (std::size_t i = 0; i < count; ++i) {
+      wintls::delete_private_key(key_name(i));
+    }
+  }
+
+  SECTION("assign_private_key and use_certificate") {
+    const auto contexts = cert_contexts(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      wintls::import_private_key(net::buffer(test_key), wintls::file_format::pem, key_name(i));
+    }
+
+    measure("assign_private_key", count, [&]() {
+      for (std::size_t i = 0; i < count; ++i) {
+        wintls::assign_private_key(contexts[i].get(), key_name(i));
+      }
+    });
+
+    // One context per certificate like a server hosting many tenants
+    std::vector<std::unique_ptr<wintls::context>> tenants;
+    tenants.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      tenants.push_back(std::make_unique<wintls::context>(wintls::method::system_default));
+    }
+    measure("use_certificate", count, [&]() {
+      for (std::size_t i = 0; i < count; ++i) {
+        tenants[i]->use_certificate(contexts[i].get());
+      }
+    });
+
+    for (std::size_t i = 0; i < count; ++i) {
+      wintls::delete_private_key(key_name(i));
+    }
+  }
+}
@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Echo throughput, latency and memory usage of wintls compared to
+// asio::ssl, using every combination of the two as client and server.
+
+#include "allocations.hpp"
+#include "benchmark.hpp"
+
+#include "asio_ssl_client_stream.hpp"
+#include "asio_ssl_server_stream.hpp"
+#include "unittest.hpp"
+#include "wintls_server_stream.hpp"
+
+#include <wintls.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// The contexts are shared by all connections, like they would be in a
+// real application, so creating them isn't part of the measurements
+struct matrix_contexts {
+  wintls::context wintls_client{wintls::method::system_default};
+  wintls_server_context wintls_server;
+  asio_ssl_client_context openssl_client;
+  asio_ssl_server_context openssl_server;
+};
+
+struct wintls_tls {
+  using stream_type = wintls::stream<test_stream>;
+  static constexpr auto client = wintls::handshake_type::client;
+  static constexpr auto server = wintls::handshake_type::server;
+
+  static const char* name() {
+    return "wintls";
+  }
+
+  static wintls::context& client_context(matrix_contexts& contexts) {
+    return contexts.wintls_client;
+  }
+
+  static wintls::context& server_context(matrix_contexts& contexts) {
+    return contexts.wintls_server;
+  }
+};
+
+struct openssl_tls {
+  using stream_type = asio_ssl::stream<test_stream>;
+  static constexpr auto client = asio_ssl::stream_base::client;
+  static constexpr auto server = asio_ssl::stream_base::server;
+
+  static const char* name() {
+    return "openssl";
+  }
+
+  static asio_ssl::context& client_context(matrix_contexts& contexts) {
+    return contexts.openssl_client;
+  }
+
+  static asio_ssl::context& server_context(matrix_contexts& contexts) {
+    return contexts.openssl_server;
+  }
+};
+
+// A connected client and server echoing a message back and forth,
+// recording the round trip time of each echo as seen by the client.
+//
+// The echoing is run on separate threads so errors are stored instead
+// of using the (not thread safe) Catch assertion macros.
+template <typename Client, typename Server>
+class echo_pair {
+public:
+  echo_pair(net::io_context& ioc, matrix_contexts& contexts)
+    : client_(ioc, Client::client_context(contexts))
+    , server_(ioc, Server::server_context(contexts)) {
+    client_.next_layer().connect(server_.next_layer());
+  }
+
+  void handshake() {
+    client_.async_handshake(Client::client, [](const error_code& ec) {
+      REQUIRE_FALSE(ec);
+    });
+    server_.async_handshake(Server::server, [](const error_code& ec) {
+      REQUIRE_FALSE(ec);
+    });
+  }
+
+  void echo(const std::string& message, std::size_t count) {
+    remaining_ = count;
+    server_remaining_ = count;
+    message_ = net::buffer(message);
+    client_buffer_.resize(message.size());
+    server_buffer_.resize(message.size());
+    latencies_.reserve(count);
+    do_server_read();
+    do_client_write();
+  }
+
+  const latency_recorder& latencies() const {
+    return latencies_;
+  }
+
+  const error_code& error() const {
+    return error_;
+  }
+
+private:
+  void do_client_write() {
+    const auto start = bench_clock::now();
+    net::async_write(client_, message_, [this, start](const error_code& ec, std::size_t) {
+      if (ec) {
+        return fail(ec);
+      }
+      net::async_read(client_, net::buffer(client_buffer_), [this, start](const error_code& read_ec, std::size_t) {
+        if (read_ec) {
+          return fail(read_ec);
+        }
+        latencies_.record(bench_clock::now() - start);
+        if (--remaining_ > 0) {
+          do_client_write();
+        }
+      });
+    });
+  }
+
+  void do_server_read() {
+    net::async_read(server_, net::buffer(server_buffer_), [this](const error_code& ec, std::size_t) {
+      if (ec) {
+        return fail(ec);
+      }
+      net::async_write(server_, net::buffer(server_buffer_), [this](const error_code& write_ec, std::size_t) {
+        if (write_ec) {
+          return fail(write_ec);
+        }
+        if (--server_remaining_ > 0) {
+          do_server_read();
+        }
+      });
+    });
+  }
+
+  void fail(const error_code& ec) {
+    if (!error_) {
+      error_ = ec;
+      // Make sure the other side doesn't wait forever
+      client_.next_layer().close();
+      server_.next_layer().close();
+    }
+  }
+
+  typename Client::stream_type client_;
+  typename Server::stream_type server_;
+  net::const_buffer message_;
+  std::vector<char> client_buffer_;
+  std::vector<char> server_buffer_;
+  latency_recorder latencies_;
+  error_code error_;
+  std::size_t remaining_ = 0;
+  std::size_t server_remaining_ = 0;
+};
+
+} // namespace
+
+using MatrixTypes = std::tuple<std::tuple<wintls_tls, wintls_tls>,
+                               std::tuple<wintls_tls, openssl_tls>,
+                               std::tuple<openssl_tls, wintls_tls>,
+                               std::tuple<openssl_tls, openssl_tls>>;
+
+TEMPLATE_LIST_TEST_CASE("echo matrix", "[matrix]", MatrixTypes) {
+  using Client = typename std::tuple_element<0, TestType>::type;
+  using Server = typename std::tuple_element<1, TestType>::type;
+
+  const auto message_size = GENERATE(as<std::size_t>{}, 64, 0x400, 0x4000, 0x100000);
+  const auto thread_count = GENERATE(as<std::size_t>{}, 1, 4);
+
+  // Aim for roughly the same amount of data for all sizes
+  const auto count = std::min<std::size_t>(20000, std::max<std::size_t>(0x2000000 / message_size, 32));
+  const auto message = generate_data(message_size);
+  matrix_contexts ctxs;
+
+  // One io_context with a single connection per thread
+  const auto allocations_before = current_allocations();
+  std::vector<std::unique_ptr<net::io_context>> io_contexts;
+  std::vector<std::unique_ptr<echo_pair<Client, Server>>> pairs;
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    io_contexts.push_back(std::make_unique<net::io_context>(1));
+    pairs.push_back(std::make_unique<echo_pair<Client, Server>>(*io_contexts.back(), ctxs));
+    pairs.back()->handshake();
+    io_contexts.back()->run();
+    io_contexts.back()->restart();
+  }
+
+  const auto start = bench_clock::now();
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    pairs[i]->echo(message, count);
+    threads.emplace_back([&ioc = *io_contexts[i]]() {
+      ioc.run();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto elapsed = bench_clock::now() - start;
+  const auto allocations_after = current_allocations();
+
+  latency_recorder latencies;
+  for (const auto& pair : pairs) {
+    REQUIRE_FALSE(pair->error());
+    latencies.merge(pair->latencies());
+  }
+  REQUIRE(latencies.count() == count * thread_count);
+
+  benchmark_result result;
+  result.name = std::string{"matrix/"} + Client::name() + "-" + Server::name() + "/" + size_name(message_size) + "/" +
+                std::to_string(thread_count) + "t";
+  result.operations = count * thread_count;
+  result.bytes = 2 * count * thread_count * message_size;
+  result.elapsed = elapsed;
+  // Includes creating the connections and the handshakes which is
+  // where most of the per connection memory is allocated
+  result.has_allocations = true;
+  result.allocations = allocations_after.count - allocations_before.count;
+  result.allocated_bytes = allocations_after.bytes - allocations_before.bytes;
+  result.private_bytes_delta = static_cast<std::ptrdiff_t>(allocations_after.private_bytes) -
+                               static_cast<std::ptrdiff_t>(allocations_before.private_bytes);
+  report(result, &latencies);
+}
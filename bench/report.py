@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+#
+# Distributed under the Boost Software License, Version 1.0. (See accompanying
+# file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#
+
+"""Generate markdown tables from the output of the benchmark executable.
+
+Every BENCHMARK line is listed in a table of its own group (the first
+part of the name). The results of the echo matrix are additionally
+pivoted into a table per metric comparing the client/server
+combinations side by side for each payload size and thread count.
+
+Usage: benchmark | report.py
+       report.py benchmark-output.txt
+"""
+
+import argparse
+import collections
+import sys
+
+COLUMNS = ["ops", "ops_per_second", "mib_per_second", "p50_us", "p99_us",
+           "max_us", "allocations", "private_bytes_delta"]
+
+MATRIX_METRICS = [("mib_per_second", "Throughput (MiB/s)"),
+                  ("p99_us", "p99 latency (us)"),
+                  ("private_bytes_delta", "Private bytes")]
+
+
+def parse(lines):
+    results = []
+    for line in lines:
+        if not line.startswith("BENCHMARK "):
+            continue
+        fields = dict(field.split("=", 1) for field in line.split()[1:])
+        results.append(fields)
+    return results
+
+
+def table(header, rows):
+    out = ["| " + " | ".join(header) + " |",
+           "|" + "|".join("---" for _ in header) + "|"]
+    out += ["| " + " | ".join(row) + " |" for row in rows]
+    return "\n".join(out)
+
+
+def group_tables(results):
+    groups = collections.OrderedDict()
+    for result in results:
+        groups.setdefault(result["name"].split("/")[0], []).append(result)
+    out = []
+    for group, group_results in groups.items():
+        columns = [column for column in COLUMNS
+                   if any(column in result for result in group_results)]
+        rows = [[result["name"]] + [result.get(column, "") for column in columns]
+                for result in group_results]
+        out.append("## " + group + "\n\n" + table(["name"] + columns, rows))
+    return out
+
+
+def matrix_tables(results):
+    # Names are matrix/<client>-<server>/<size>/<threads>t
+    matrix = [result for result in results if result["name"].startswith("matrix/")]
+    if not matrix:
+        return []
+    pairs = []
+    cells = collections.OrderedDict()
+    for result in matrix:
+        _, pair, size, threads = result["name"].split("/")
+        if pair not in pairs:
+            pairs.append(pair)
+        cells.setdefault((size, threads), {})[pair] = result
+    out = []
+    for metric, title in MATRIX_METRICS:
+        rows = [[size, threads] + [row.get(pair, {}).get(metric, "") for pair in pairs]
+                for (size, threads), row in cells.items()]
+        out.append("## " + title + "\n\n" + table(["size", "threads"] + pairs, rows))
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", type=argparse.FileType("r"), default=sys.stdin,
+                        help="benchmark output (default: stdin)")
+    args = parser.parse_args()
+
+    results = parse(args.input)
+    if not results:
+        sys.exit("No benchmark results found")
+    print("\n\n".join(group_tables(results) + matrix_tables(results)))
+
+
+if __name__ == "__main__":
+    main()
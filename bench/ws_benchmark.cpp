@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "benchmark.hpp"
+
+#include "unittest.hpp"
+#include "wintls_client_stream.hpp"
+#include "wintls_server_stream.hpp"
+
+#include <wintls.hpp>
+
+#include <algorithm>
+#include <string>
+
+namespace {
+
+// A connected pair of websocket streams on top of the given client
+// and server TLS streams. Each phase (handshake, echo, close) is run
+// to completion on the io_context before returning.
+template <typename ClientStream, typename ServerStream>
+class ws_pair {
+public:
+  ws_pair(net::io_context& ioc, bool deflate)
+    : ioc_(ioc)
+    , client_(ioc)
+    , server_(ioc)
+    , client_ws_(client_.stream)
+    , server_ws_(server_.stream) {
+    client_.stream.next_layer().connect(server_.stream.next_layer());
+    if (deflate) {
+      websocket::permessage_deflate pmd;
+      pmd.client_enable = true;
+      pmd.server_enable = true;
+      client_ws_.set_option(pmd);
+      server_ws_.set_option(pmd);
+    }
+    client_ws_.binary(true);
+    server_ws_.binary(true);
+  }
+
+  void handshake() {
+    client_ws_.next_layer().async_handshake(ClientStream::handshake_type::client, [this](const error_code& ec) {
+      REQUIRE_FALSE(ec);
+      client_ws_.async_handshake("localhost", "/", [](const error_code& ws_ec) {
+        REQUIRE_FALSE(ws_ec);
+      });
+    });
+    server_ws_.next_layer().async_handshake(ServerStream::handshake_type::server, [this](const error_code& ec) {
+      REQUIRE_FALSE(ec);
+      server_ws_.async_accept([](const error_code& ws_ec) {
+        REQUIRE_FALSE(ws_ec);
+      });
+    });
+    run();
+  }
+
+  // Sends the message count times, waiting for each echo before
+  // sending the next, recording the round trip time of each.
+  void echo(const std::string& message, std::size_t count, latency_recorder& latencies) {
+    remaining_ = count;
+    server_remaining_ = count;
+    message_ = net::buffer(message);
+    do_server_read();
+    do_client_write(latencies);
+    run();
+  }
+
+  // Close the websocket connection initiated by the given role. The
+  // other side detects the close while reading, so both sides end up
+  // tearing down the TLS stream, but using different paths.
+  void close(beast::role_type role) {
+    if (role == beast::role_type::client) {
+      server_ws_.async_read(server_buffer_, [](const error_code& ec, std::size_t) {
+        CHECK(ec == websocket::error::closed);
+      });
+      client_ws_.async_close(websocket::close_code::normal, [](const error_code& ec) {
+        REQUIRE_FALSE(ec);
+      });
+    } else {
+      client_ws_.async_read(client_buffer_, [](const error_code& ec, std::size_t) {
+        CHECK(ec == websocket::error::closed);
+      });
+      server_ws_.async_close(websocket::close_code::normal, [](const error_code& ec) {
+        REQUIRE_FALSE(ec);
+      });
+    }
+    run();
+  }
+
+private:
+  void run() {
+    ioc_.restart();
+    ioc_.run();
+  }
+
+  void do_client_write(latency_recorder& latencies) {
+    const auto start = bench_clock::now();
+    client_ws_.async_write(message_, [this, start, &latencies](const error_code& ec, std::size_t) {
+      REQUIRE_FALSE(ec);
+      client_buffer_.clear();
+      client_ws_.async_read(client_buffer_, [this, start, &latencies](const error_code& read_ec, std::size_t) {
+        REQUIRE_FALSE(read_ec);
+        latencies.record(bench_clock::now() - start);
+        if (--remaining_ > 0) {
+          do_client_write(latencies);
+        }
+      });
+    });
+  }
+
+  void do_server_read() {
+    server_buffer_.clear();
+    server_ws_.async_read(server_buffer_, [this](const error_code& ec, std::size_t) {
+      REQUIRE_FALSE(ec);
+      server_ws_.async_write(server_buffer_.data(), [this](const error_code& write_ec, std::size_t) {
+        REQUIRE_FALSE(write_ec);
+        if (--server_remaining_ > 0) {
+          do_server_read();
+        }
+      });
+    });
+  }
+
+  net::io_context& ioc_;
+  ClientStream client_;
+  ServerStream server_;
+  websocket::stream<decltype(ClientStream::stream)&> client_ws_;
+  websocket::stream<decltype(ServerStream::stream)&> server_ws_;
+  beast::flat_buffer client_buffer_;
+  beast::flat_buffer server_buffer_;
+  net::const_buffer message_;
+  std::size_t remaining_ = 0;
+  std::size_t server_remaining_ = 0;
+};
+
+using wintls_ws_pair = ws_pair<wintls_client_stream, wintls_server_stream>;
+
+std::string deflate_name(bool deflate) {
+  return deflate ? "deflate" : "plain";
+}
+
+} // namespace
+
+TEST_CASE("websocket message throughput and latency", "[ws]") {
+  const auto message_size = GENERATE(as<std::size_t>{}, 64, 0x100000);
+  const auto deflate = GENERATE(false, true);
+
+  // Aim for roughly the same amount of data for all sizes
+  const auto count = std::min<std::size_t>(20000, std::max<std::size_t>(0x4000000 / message_size, 32));
+  const auto message = generate_data(message_size);
+
+  net::io_context ioc;
+  wintls_ws_pair pair(ioc, deflate);
+  pair.handshake();
+
+  latency_recorder latencies;
+  latencies.reserve(count);
+  const auto start = bench_clock::now();
+  pair.echo(message, count, latencies);
+  const auto elapsed = bench_clock::now() - start;
+  REQUIRE(latencies.count() == count);
+
+  benchmark_result result;
+  result.name = "ws/echo/" + size_name(message_size) + "/" + deflate_name(deflate);
+  result.operations = count;
+  result.bytes = 2 * count * message_size;
+  result.elapsed = elapsed;
+  report(result, &latencies);
+
+  pair.close(beast::role_type::client);
+}
+
+TEST_CASE("websocket handshake and close", "[ws]") {
+  const auto role = GENERATE(beast::role_type::client, beast::role_type::server);
+  const auto deflate = GENERATE(false, true);
+  const std::size_t count = 200;
+
+  latency_recorder latencies;
+  latencies.reserve(count);
+  bench_clock::duration elapsed{};
+  for (std::size_t i = 0; i < count; ++i) {
+    net::io_context ioc;
+    wintls_ws_pair pair(ioc, deflate);
+    const auto start = bench_clock::now();
+    pair.handshake();
+    const auto close_start = bench_clock::now();
+    pair.close(role);
+    const auto end = bench_clock::now();
+    latencies.record(end - close_start);
+    elapsed += end - start;
+  }
+
+  benchmark_result result;
+  result.name = std::string{"ws/close/"} + (role == beast::role_type::client ? "client" : "server") + "/" +
+                deflate_name(deflate);
+  result.operations = count;
+  result.elapsed = elapsed;
+  report(result, &latencies);
+}
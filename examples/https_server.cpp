@@ -0,0 +1,391 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Multi-threaded HTTPS server with one io_context per core.
+//
+// Windows has no SO_REUSEPORT for spreading connections between
+// several listening sockets, so a single acceptor keeps an accept
+// outstanding for each shard, handing each accepted socket directly to
+// the io_context of that shard. All connections share a single
+// wintls::context.
+//
+// Supports keep-alive and pipelined requests, drains the connections
+// gracefully on Ctrl-C and serves statistics as JSON on /stats.
+
+#include "certificate.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <boost/optional.hpp>
+
+#include <wintls.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace beast = boost::beast;   // from <boost/beast.hpp>
+namespace http = beast::http;     // from <boost/beast/http.hpp>
+namespace net = boost::asio;      // from <boost/asio.hpp>
+
+using tcp = boost::asio::ip::tcp; // from <boost/asio/ip/tcp.hpp>
+
+//------------------------------------------------------------------------------
+
+struct shard_stats {
+  std::atomic<std::uint64_t> accepted{0};
+  std::atomic<std::uint64_t> handshakes{0};
+  std::atomic<std::uint64_t> requests{0};
+  std::atomic<std::uint64_t> errors{0};
+  std::atomic<std::int64_t> active{0};
+};
+
+class session;
+
+// An io_context run by a single thread together with the sessions
+// running on it. The sessions are only accessed from that thread.
+struct shard {
+  net::io_context ioc{1};
+  shard_stats stats;
+  std::unordered_set<session*> sessions;
+  bool draining = false;
+};
+
+// Report a failure
+void fail(shard& s, beast::error_code ec, char const* what) {
+  // Expected when draining or when the client closes the connection
+  if (ec == net::error::operation_aborted || ec == http::error::end_of_stream || ec == net::error::eof) {
+    return;
+  }
+  ++s.stats.errors;
+  std::cerr << what << ": " << ec.message() << "\n";
+}
+
+std::string stats_json(const std::vector<std::unique_ptr<shard>>& shards) {
+  std::ostringstream oss;
+  oss << "{\"shards\":[";
+  for (std::size_t i = 0; i < shards.size(); ++i) {
+    const auto& stats = shards[i]->stats;
+    oss << (i > 0 ? "," : "")
+        << "{\"accepted\":" << stats.accepted
+        << ",\"handshakes\":" << stats.handshakes
+        << ",\"requests\":" << stats.requests
+        << ",\"errors\":" << stats.errors
+        << ",\"active\":" << stats.active << "}";
+  }
+  oss << "]}\n";
+  return oss.str();
+}
+
+// Handles an HTTP server connection. Up to queue_limit requests are
+// read ahead of the responses being written, which is what makes
+// pipelining work.
+class session : public std::enable_shared_from_this<session> {
+  static constexpr std::size_t queue_limit = 8;
+
+public:
+  session(tcp::socket socket, wintls::context& ctx, shard& s, const std::vector<std::unique_ptr<shard>>& shards)
+    : stream_(std::move(socket), ctx)
+    , shard_(s)
+    , shards_(shards) {
+    ++shard_.stats.active;
+  }
+
+  ~session() {
+    shard_.sessions.erase(this);
+    --shard_.stats.active;
+  }
+
+  // Must be called from the thread running the shard
+  void run() {
+    shard_.sessions.insert(this);
+    beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(30));
+    stream_.async_handshake(wintls::handshake_type::server,
+                            beast::bind_front_handler(&session::on_handshake, shared_from_this()));
+  }
+
+  // Stop reading new requests and close the connection once the
+  // responses to the requests already read have been written
+  void drain() {
+    if (responses_.empty()) {
+      // Idle, abort the pending read
+      beast::get_lowest_layer(stream_).cancel();
+    }
+  }
+
+private:
+  void on_handshake(beast::error_code ec) {
+    if (ec) {
+      return fail(shard_, ec, "handshake");
+    }
+    ++shard_.stats.handshakes;
+    do_read();
+  }
+
+  void do_read() {
+    if (shard_.draining) {
+      if (responses_.empty()) {
+        do_shutdown();
+      }
+      return;
+    }
+    reading_ = true;
+    parser_.emplace();
+    parser_->body_limit(0x10000);
+    // Idle keep-alive connections are closed after a while
+    beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(30));
+    http::async_read(stream_, buffer_, *parser_, beast::bind_front_handler(&session::on_read, shared_from_this()));
+  }
+
+  void on_read(beast::error_code ec, std::size_t) {
+    reading_ = false;
+    if (ec) {
+      fail(shard_, ec, "read");
+      if (responses_.empty()) {
+        do_shutdown();
+      }
+      return;
+    }
+    ++shard_.stats.requests;
+    queue_response(handle_request(parser_->release()));
+
+    if (responses_.size() < queue_limit) {
+      do_read();
+    }
+  }
+
+  http::response<http::string_body> handle_request(const http::request<http::string_body>& req) {
+    http::response<http::string_body> res;
+    res.version(req.version());
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    if (req.method() != http::verb::get && req.method() != http::verb::head) {
+      res.result(http::status::bad_request);
+      res.set(http::field::content_type, "text/plain");
+      res.body() = "Unsupported HTTP method\n";
+    } else if (req.target() == "/stats") {
+      res.result(http::status::ok);
+      res.set(http::field::content_type, "application/json");
+      res.body() = stats_json(shards_);
+    } else if (req.target() == "/") {
+      res.result(http::status::ok);
+      res.set(http::field::content_type, "text/plain");
+      res.body() = "Hello from wintls\n";
+    } else {
+      res.result(http::status::not_found);
+      res.set(http::field::content_type, "text/plain");
+      res.body() = "Not found\n";
+    }
+    res.keep_alive(req.keep_alive() && !shard_.draining);
+    res.prepare_payload();
+    if (req.method() == http::verb::head) {
+      res.body().clear();
+    }
+    return res;
+  }
+
+  void queue_response(http::response<http::string_body> res) {
+    responses_.push_back(std::move(res));
+    if (responses_.size() == 1) {
+      do_write();
+    }
+  }
+
+  void do_write() {
+    beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(30));
+    http::async_write(stream_, responses_.front(), beast::bind_front_handler(&session::on_write, shared_from_this()));
+  }
+
+  void on_write(beast::error_code ec, std::size_t) {
+    if (ec) {
+      return fail(shard_, ec, "write");
+    }
+    const bool keep_alive = responses_.front().keep_alive();
+    const bool was_full = responses_.size() == queue_limit;
+    responses_.pop_front();
+
+    if (!keep_alive) {
+      return do_shutdown();
+    }
+    if (!responses_.empty()) {
+      do_write();
+    }
+    if (was_full && !reading_) {
+      do_read();
+    } else if (shard_.draining && responses_.empty()) {
+      if (reading_) {
+        // Abort waiting for a request which will never be answered
+        beast::get_lowest_layer(stream_).cancel();
+      } else {
+        do_shutdown();
+      }
+    }
+  }
+
+  void do_shutdown() {
+    if (shutting_down_) {
+      return;
+    }
+    shutting_down_ = true;
+    beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(5));
+    stream_.async_shutdown([self = shared_from_this()](beast::error_code) {
+      beast::error_code ignored;
+      beast::get_lowest_layer(self->stream_).socket().shutdown(tcp::socket::shutdown_both, ignored);
+      beast::get_lowest_layer(self->stream_).close();
+    });
+  }
+
+  wintls::stream<beast::tcp_stream> stream_;
+  shard& shard_;
+  const std::vector<std::unique_ptr<shard>>& shards_;
+  beast::flat_buffer buffer_;
+  boost::optional<http::request_parser<http::string_body>> parser_;
+  std::deque<http::response<http::string_body>> responses_;
+  bool reading_ = false;
+  bool shutting_down_ = false;
+};
+
+// Accepts connections with one accept outstanding per shard. Each
+// accepted socket is bound to the io_context of its shard so the
+// session never touches the acceptor thread.
+class listener {
+public:
+  listener(net::io_context& ioc,
+           const tcp::endpoint& endpoint,
+           wintls::context& ctx,
+           const std::vector<std::unique_ptr<shard>>& shards)
+    : acceptor_(ioc, endpoint)
+    , ctx_(ctx)
+    , shards_(shards) {
+  }
+
+  void run() {
+    for (auto& s : shards_) {
+      do_accept(*s);
+    }
+  }
+
+  void stop() {
+    beast::error_code ignored;
+    acceptor_.close(ignored);
+  }
+
+private:
+  void do_accept(shard& s) {
+    acceptor_.async_accept(s.ioc, [this, &s](beast::error_code ec, tcp::socket socket) {
+      if (ec == net::error::operation_aborted) {
+        return;
+      }
+      if (ec) {
+        fail(s, ec, "accept");
+      } else {
+        ++s.stats.accepted;
+        net::post(s.ioc, [this, &s, socket = std::move(socket)]() mutable {
+          std::make_shared<session>(std::move(socket), ctx_, s, shards_)->run();
+        });
+      }
+      do_accept(s);
+    });
+  }
+
+  tcp::acceptor acceptor_;
+  wintls::context& ctx_;
+  const std::vector<std::unique_ptr<shard>>& shards_;
+};
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+  if (argc != 3 && argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " <address> <port> [threads]\n\n"
+              << "Example: " << argv[0] << " 0.0.0.0 8443 4\n";
+    return EXIT_FAILURE;
+  }
+  const auto address = net::ip::make_address(argv[1]);
+  const auto port = static_cast<unsigned short>(std::atoi(argv[2]));
+  const auto threads = argc == 4 ? static_cast<std::size_t>(std::max(std::atoi(argv[3]), 1))
+                                 : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+  const std::string private_key_name = "wintls-https-server-example";
+  try {
+    // A single context shared by all connections on all threads
+    wintls::context ctx{wintls::method::system_default};
+    auto certificate = wintls::x509_to_cert_context(net::buffer(x509_certificate), wintls::file_format::pem);
+    wintls::error_code ec;
+    wintls::import_private_key(net::buffer(rsa_key), wintls::file_format::pem, private_key_name, ec);
+    // If the key already exists, assume it's the one already imported
+    if (ec && ec.value() != NTE_EXISTS) {
+      throw wintls::system_error(ec);
+    }
+    wintls::assign_private_key(certificate.get(), private_key_name);
+    ctx.use_certificate(certificate.get());
+
+    std::vector<std::unique_ptr<shard>> shards;
+    for (std::size_t i = 0; i < threads; ++i) {
+      shards.push_back(std::make_unique<shard>());
+    }
+
+    // Accepting and signal handling is done on the first shard
+    auto& main_ioc = shards.front()->ioc;
+    listener l(main_ioc, tcp::endpoint{address, port}, ctx, shards);
+    l.run();
+
+    // Keep all shards running until drained
+    std::vector<net::executor_work_guard<net::io_context::executor_type>> work;
+    for (auto& s : shards) {
+      work.push_back(net::make_work_guard(s->ioc));
+    }
+
+    net::signal_set signals(main_ioc, SIGINT, SIGTERM);
+    signals.async_wait([&](beast::error_code, int) {
+      std::cout << "Draining connections\n";
+      l.stop();
+      for (auto& s : shards) {
+        net::post(s->ioc, [&draining_shard = *s]() {
+          draining_shard.draining = true;
+          for (auto* sess : draining_shard.sessions) {
+            sess->drain();
+          }
+        });
+      }
+      work.clear();
+    });
+
+    std::cout << "Listening on " << address << ":" << port << " using " << threads << " threads\n";
+
+    std::vector<std::thread> runners;
+    for (auto& s : shards) {
+      runners.emplace_back([&s]() {
+        s->ioc.run();
+      });
+    }
+    for (auto& runner : runners) {
+      runner.join();
+    }
+
+    std::cout << stats_json(shards);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+  }
+
+  // Most real applications probably only want to import the key once
+  // and not in the server code. This is just for demonstration purposes.
+  wintls::error_code ec;
+  wintls::delete_private_key(private_key_name, ec);
+
+  return EXIT_SUCCESS;
+}
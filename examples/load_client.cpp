@@ -0,0 +1,514 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// wintls-load: Load generator driving a large number of HTTPS or echo
+// connections from a pool of threads each running an io_context.
+//
+// Requests are sent at a fixed rate per connection when a target rate
+// is given. Latencies are measured from the time a request was
+// scheduled to be sent, not when it actually was, so a stalled server
+// doesn't hide the requests that should have been sent in the meantime
+// (coordinated omission).
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+
+#include <wintls.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace beast = boost::beast;   // from <boost/beast.hpp>
+namespace http = beast::http;     // from <boost/beast/http.hpp>
+namespace net = boost::asio;      // from <boost/asio.hpp>
+
+using tcp = boost::asio::ip::tcp; // from <boost/asio/ip/tcp.hpp>
+using clock_type = std::chrono::steady_clock;
+
+//------------------------------------------------------------------------------
+
+// Log-linear latency histogram in microseconds. Values are recorded
+// with a precision of 1/32 of their magnitude, which keeps the
+// histogram small enough to have one per thread without any locking.
+class latency_histogram {
+public:
+  latency_histogram()
+    : counts_(bucket_count, 0) {
+  }
+
+  void record(clock_type::duration latency) {
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    const auto value = static_cast<std::uint64_t>(std::max<std::chrono::microseconds::rep>(us, 0));
+    ++counts_[index(value)];
+    ++total_;
+    max_ = std::max(max_, value);
+  }
+
+  void merge(const latency_histogram& other) {
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  std::uint64_t count() const {
+    return total_;
+  }
+
+  std::uint64_t max() const {
+    return max_;
+  }
+
+  // Percentile in the range [0, 100]. Returns the highest value of the
+  // bucket the percentile falls in.
+  std::uint64_t percentile(double p) const {
+    const auto rank = std::max<std::uint64_t>(static_cast<std::uint64_t>(p / 100.0 * static_cast<double>(total_) + 0.5), 1);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return std::min(highest_value(i), max_);
+      }
+    }
+    return max_;
+  }
+
+private:
+  static constexpr unsigned sub_bucket_bits = 5;
+  static constexpr std::uint64_t sub_bucket_count = 1 << sub_bucket_bits;
+  static constexpr std::size_t bucket_count = (64 - sub_bucket_bits + 1) * sub_bucket_count;
+
+  static std::size_t index(std::uint64_t value) {
+    if (value < 2 * sub_bucket_count) {
+      return static_cast<std::size_t>(value);
+    }
+    unsigned msb = 0;
+    while ((value >> (msb + 1)) != 0) {
+      ++msb;
+    }
+    const unsigned exponent = msb - sub_bucket_bits;
+    return static_cast<std::size_t>(exponent * sub_bucket_count + (value >> exponent));
+  }
+
+  static std::uint64_t highest_value(std::size_t index) {
+    if (index < 2 * sub_bucket_count) {
+      return index;
+    }
+    const auto exponent = static_cast<unsigned>(index / sub_bucket_count - 1);
+    const auto mantissa = index - exponent * sub_bucket_count;
+    return ((static_cast<std::uint64_t>(mantissa) + 1) << exponent) - 1;
+  }
+
+  std::vector<std::uint64_t> counts_;
+  std::uint64_t total_ = 0;
+  std::uint64_t max_ = 0;
+};
+
+struct load_options {
+  bool echo = false;
+  std::string host;
+  std::string port;
+  std::string path = "/";
+  std::size_t connections = 100;
+  std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+  double rate = 0; // Requests per second for all connections, 0 means as fast as possible
+  std::chrono::seconds duration{10};
+  std::size_t size = 64; // Echo message size
+  bool reconnect = false;
+  bool verify = false;
+};
+
+struct load_stats {
+  std::atomic<std::uint64_t> connects{0};
+  std::atomic<std::uint64_t> handshakes{0};
+  std::atomic<std::uint64_t> requests{0};
+  std::atomic<std::uint64_t> bytes{0};
+  std::atomic<std::uint64_t> errors{0};
+  std::atomic<std::size_t> active{0};
+};
+
+// A single connection repeatedly sending requests until the deadline
+// is reached. All connections sharing an io_context share the same
+// histogram as they are all run from the same thread.
+class connection : public std::enable_shared_from_this<connection> {
+public:
+  connection(net::io_context& ioc,
+             wintls::context& ctx,
+             const load_options& options,
+             const tcp::resolver::results_type& endpoints,
+             load_stats& stats,
+             latency_histogram& histogram,
+             clock_type::time_point start,
+             clock_type::time_point deadline,
+             clock_type::duration interval)
+    : ioc_(ioc)
+    , ctx_(ctx)
+    , options_(options)
+    , endpoints_(endpoints)
+    , stats_(stats)
+    , histogram_(histogram)
+    , timer_(ioc)
+    , deadline_(deadline)
+    , interval_(interval)
+    , next_send_(start)
+    , message_(options.size, 'x')
+    , echo_buffer_(options.size) {
+    req_.version(11);
+    req_.method(http::verb::get);
+    req_.target(options.path);
+    req_.set(http::field::host, options.host);
+    req_.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    req_.keep_alive(!options.reconnect);
+  }
+
+  void run() {
+    ++stats_.active;
+    do_connect();
+  }
+
+private:
+  void do_connect() {
+    stream_ = std::make_unique<wintls::stream<tcp::socket>>(ioc_, ctx_);
+    if (!options_.echo) {
+      stream_->set_server_hostname(options_.host);
+    }
+    net::async_connect(stream_->next_layer(), endpoints_,
+                       [self = shared_from_this()](const beast::error_code& ec, const tcp::endpoint&) {
+      self->on_connect(ec);
+    });
+  }
+
+  void on_connect(const beast::error_code& ec) {
+    if (ec) {
+      return fail(ec);
+    }
+    ++stats_.connects;
+    stream_->async_handshake(wintls::handshake_type::client,
+                             beast::bind_front_handler(&connection::on_handshake, shared_from_this()));
+  }
+
+  void on_handshake(const beast::error_code& ec) {
+    if (ec) {
+      return fail(ec);
+    }
+    ++stats_.handshakes;
+    if (reconnecting_) {
+      // The request was scheduled before the connection was made
+      reconnecting_ = false;
+      return send();
+    }
+    schedule();
+  }
+
+  // Wait for the next scheduled send time, if any
+  void schedule() {
+    if (options_.rate <= 0) {
+      next_send_ = clock_type::now();
+    }
+    if (next_send_ >= deadline_) {
+      return done();
+    }
+    if (next_send_ <= clock_type::now()) {
+      // Behind schedule, send right away
+      return start_request();
+    }
+    timer_.expires_at(next_send_);
+    timer_.async_wait([self = shared_from_this()](const beast::error_code& ec) {
+      if (!ec) {
+        self->start_request();
+      }
+    });
+  }
+
+  void start_request() {
+    if (stream_) {
+      return send();
+    }
+    reconnecting_ = true;
+    do_connect();
+  }
+
+  void send() {
+    if (options_.echo) {
+      net::async_write(*stream_, net::buffer(message_),
+                       beast::bind_front_handler(&connection::on_write, shared_from_this()));
+    } else {
+      http::async_write(*stream_, req_,
+                        beast::bind_front_handler(&connection::on_write, shared_from_this()));
+    }
+  }
+
+  void on_write(const beast::error_code& ec, std::size_t length) {
+    if (ec) {
+      return fail(ec);
+    }
+    stats_.bytes += length;
+    if (options_.echo) {
+      net::async_read(*stream_, net::buffer(echo_buffer_),
+                      beast::bind_front_handler(&connection::on_read, shared_from_this()));
+    } else {
+      res_ = {};
+      http::async_read(*stream_, buffer_, res_,
+                       beast::bind_front_handler(&connection::on_read, shared_from_this()));
+    }
+  }
+
+  void on_read(const beast::error_code& ec, std::size_t length) {
+    if (ec) {
+      return fail(ec);
+    }
+    stats_.bytes += length;
+    ++stats_.requests;
+    // Measured from when the request should have been sent
+    histogram_.record(clock_type::now() - next_send_);
+    next_send_ += interval_;
+
+    if (options_.reconnect || (!options_.echo && res_.need_eof())) {
+      return do_shutdown();
+    }
+    schedule();
+  }
+
+  void do_shutdown() {
+    stream_->async_shutdown([self = shared_from_this()](const beast::error_code&) {
+      // The connection is closed in any case, so shutdown errors
+      // aren't treated as failed requests
+      self->close();
+      self->schedule();
+    });
+  }
+
+  void fail(const beast::error_code& ec) {
+    // Only report the first error to avoid flooding the output
+    if (stats_.errors++ == 0) {
+      std::cerr << "Connection error: " << ec.message() << "\n";
+    }
+    close();
+    reconnecting_ = false;
+
+    // Don't hammer a failing server, wait a bit before reconnecting.
+    // The requests that should have been sent in the meantime are
+    // counted as late, not skipped.
+    timer_.expires_after(std::chrono::milliseconds(100));
+    timer_.async_wait([self = shared_from_this()](const beast::error_code& wait_ec) {
+      if (wait_ec) {
+        return;
+      }
+      if (clock_type::now() >= self->deadline_) {
+        return self->done();
+      }
+      self->start_request();
+    });
+  }
+
+  void close() {
+    if (stream_) {
+      beast::error_code ignored;
+      stream_->next_layer().close(ignored);
+      stream_.reset();
+    }
+  }
+
+  void done() {
+    if (stream_) {
+      stream_->async_shutdown([self = shared_from_this()](const beast::error_code&) {
+        self->close();
+        --self->stats_.active;
+      });
+      return;
+    }
+    --stats_.active;
+  }
+
+  net::io_context& ioc_;
+  wintls::context& ctx_;
+  const load_options& options_;
+  const tcp::resolver::results_type& endpoints_;
+  load_stats& stats_;
+  latency_histogram& histogram_;
+  std::unique_ptr<wintls::stream<tcp::socket>> stream_;
+  net::steady_timer timer_;
+  clock_type::time_point deadline_;
+  clock_type::duration interval_;
+  clock_type::time_point next_send_;
+  http::request<http::empty_body> req_;
+  http::response<http::string_body> res_;
+  beast::flat_buffer buffer_;
+  std::string message_;
+  std::vector<char> echo_buffer_;
+  bool reconnecting_ = false;
+};
+
+//------------------------------------------------------------------------------
+
+void usage(const char* name) {
+  std::cerr << "Usage: " << name << " [OPTIONS] URL\n\n"
+            << "URL is either https://host[:port][/path] or echo://host:port\n\n"
+            << "Options:\n"
+            << "  -c N   Number of connections (default 100)\n"
+            << "  -t N   Number of threads (default number of cores)\n"
+            << "  -r N   Target requests per second for all connections (default unlimited)\n"
+            << "  -d N   Duration in seconds (default 10)\n"
+            << "  -s N   Message size in echo mode (default 64)\n"
+            << "  -n     New connection for each request\n"
+            << "  -v     Verify the server certificate\n\n"
+            << "Example: " << name << " -c 1000 -r 20000 -d 30 https://localhost:8443/\n";
+}
+
+bool parse_options(int argc, char** argv, load_options& options) {
+  std::string url;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg{argv[i]};
+    const bool has_value = i + 1 < argc;
+    if (arg == "-n") {
+      options.reconnect = true;
+    } else if (arg == "-v") {
+      options.verify = true;
+    } else if (arg == "-c" && has_value) {
+      options.connections = std::max<std::size_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+    } else if (arg == "-t" && has_value) {
+      options.threads = std::max<std::size_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+    } else if (arg == "-r" && has_value) {
+      options.rate = std::strtod(argv[++i], nullptr);
+    } else if (arg == "-d" && has_value) {
+      options.duration = std::chrono::seconds{std::strtol(argv[++i], nullptr, 10)};
+    } else if (arg == "-s" && has_value) {
+      options.size = std::max<std::size_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+    } else if (url.empty() && arg[0] != '-') {
+      url = arg;
+    } else {
+      return false;
+    }
+  }
+
+  // Very basic URL matching. Not a full URL validator.
+  std::regex re("(https|echo)://([^/$:]+):?([^/$]*)(/?.*)");
+  std::smatch what;
+  if (!std::regex_match(url, what, re)) {
+    return false;
+  }
+  options.echo = what[1] == "echo";
+  options.host = what[2];
+  options.port = what[3].length() > 0 ? what[3].str() : "443";
+  if (what[4].length() > 0) {
+    options.path = what[4];
+  }
+  return true;
+}
+
+void print_summary(const load_stats& stats, const latency_histogram& histogram, double seconds) {
+  std::cout << std::fixed << std::setprecision(2)
+            << "\nconnects: " << stats.connects
+            << ", handshakes: " << stats.handshakes
+            << ", requests: " << stats.requests
+            << ", errors: " << stats.errors << "\n"
+            << "handshakes/s: " << static_cast<double>(stats.handshakes) / seconds << "\n"
+            << "requests/s:   " << static_cast<double>(stats.requests) / seconds << "\n"
+            << "MiB/s:        " << static_cast<double>(stats.bytes) / seconds / 0x100000 << "\n\n"
+            << "Latency distribution (us):\n";
+  for (const double p : {50.0, 75.0, 90.0, 99.0, 99.9, 99.99}) {
+    std::cout << "  " << std::setw(6) << p << "%  " << histogram.percentile(p) << "\n";
+  }
+  std::cout << "  " << std::setw(6) << 100.0 << "%  " << histogram.max() << "\n";
+}
+
+int main(int argc, char** argv) {
+  load_options options;
+  if (!parse_options(argc, argv, options)) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  try {
+    // Only a single context is needed for all connections
+    wintls::context ctx{wintls::method::system_default};
+    if (options.verify) {
+      ctx.use_default_certificates(true);
+      ctx.verify_server_certificate(true);
+    }
+
+    // Resolve once up front instead of for every connection
+    net::io_context resolve_ioc;
+    tcp::resolver resolver{resolve_ioc};
+    const auto endpoints = resolver.resolve(options.host, options.port);
+
+    // One io_context per thread, connections are spread evenly between them
+    std::vector<std::unique_ptr<net::io_context>> io_contexts;
+    std::vector<latency_histogram> histograms(options.threads);
+    for (std::size_t i = 0; i < options.threads; ++i) {
+      io_contexts.push_back(std::make_unique<net::io_context>(1));
+    }
+
+    // Each connection gets its share of the target rate, with the
+    // start times spread out to avoid sending requests in bursts
+    clock_type::duration interval{};
+    if (options.rate > 0) {
+      const std::chrono::duration<double> seconds_per_request{static_cast<double>(options.connections) / options.rate};
+      interval = std::chrono::duration_cast<clock_type::duration>(seconds_per_request);
+    }
+
+    load_stats stats;
+    const auto start = clock_type::now();
+    const auto deadline = start + options.duration;
+    for (std::size_t i = 0; i < options.connections; ++i) {
+      const auto index = i % options.threads;
+      const auto offset = interval * static_cast<clock_type::rep>(i) / static_cast<clock_type::rep>(options.connections);
+      std::make_shared<connection>(*io_contexts[index], ctx, options, endpoints, stats, histograms[index],
+                                   start + offset, deadline, interval)->run();
+    }
+
+    std::vector<std::thread> threads;
+    for (auto& ioc : io_contexts) {
+      threads.emplace_back([&ioc]() {
+        ioc->run();
+      });
+    }
+
+    // Report progress every second until all connections are done
+    std::uint64_t last_requests = 0;
+    std::uint64_t last_handshakes = 0;
+    while (stats.active > 0) {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+      const std::uint64_t requests = stats.requests;
+      const std::uint64_t handshakes = stats.handshakes;
+      std::cout << "requests/s: " << requests - last_requests
+                << ", handshakes/s: " << handshakes - last_handshakes
+                << ", active: " << stats.active
+                << ", errors: " << stats.errors << std::endl;
+      last_requests = requests;
+      last_handshakes = handshakes;
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    latency_histogram histogram;
+    for (const auto& h : histograms) {
+      histogram.merge(h);
+    }
+    print_summary(stats, histogram, std::chrono::duration<double>(clock_type::now() - start).count());
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -11,11 +11,19 @@
 #include <wintls/detail/config.hpp>
 
 #include <wintls/certificate.hpp>
+#include <wintls/connection_pool.hpp>
+#include <wintls/connection_reservoir.hpp>
+#include <wintls/connect.hpp>
 #include <wintls/context.hpp>
+#include <wintls/context_statistics.hpp>
+#include <wintls/datagram_stream.hpp>
 #include <wintls/error.hpp>
 #include <wintls/file_format.hpp>
 #include <wintls/handshake_type.hpp>
 #include <wintls/method.hpp>
+#include <wintls/read_statistics.hpp>
+#include <wintls/relay.hpp>
+#include <wintls/send_file.hpp>
 #include <wintls/stream.hpp>
 
 #endif // WINTLS_HPP
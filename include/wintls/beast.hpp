@@ -9,6 +9,7 @@
 #define BOOST_WINTLS_BEAST_HPP
 
 #include <boost/version.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
 #include <boost/beast/websocket.hpp>
 #include <wintls/context.hpp>
 #include <wintls/stream.hpp>
@@ -72,4 +73,10 @@ void teardown(boost::beast::role_type role, wintls::stream<AsyncStream>& stream,
 } // namespace beast
 } // namespace boost
 
+#if !WINTLS_HEADER_ONLY
+namespace wintls {
+extern template class stream<boost::beast::tcp_stream>;
+} // namespace wintls
+#endif // !WINTLS_HEADER_ONLY
+
 #endif
@@ -70,18 +70,7 @@ using cert_context_ptr = std::unique_ptr<const CERT_CONTEXT, detail::cert_ctx_de
  * @throws wintls::system_error Thrown on failure.
  *
  */
-inline cert_context_ptr x509_to_cert_context(const net::const_buffer& x509, file_format format) {
-  // TODO: Support DER format
-  WINTLS_VERIFY_MSG(format == file_format::pem, "Only PEM format currently implemented");
-
-  auto data = detail::crypt_string_to_binary(x509);
-  auto cert = CertCreateCertificateContext(X509_ASN_ENCODING, data.data(), static_cast<DWORD>(data.size()));
-  if (!cert) {
-    detail::throw_last_error("CertCreateCertificateContext");
-  }
-
-  return cert_context_ptr{cert};
-}
+WINTLS_DECL cert_context_ptr x509_to_cert_context(const net::const_buffer& x509, file_format format);
 
 /**
  * @verbatim embed:rst:leading-asterisk
@@ -97,15 +86,7 @@ inline cert_context_ptr x509_to_cert_context(const net::const_buffer& x509, file
  * @return A managed cert_context.
  *
  */
-inline cert_context_ptr x509_to_cert_context(const net::const_buffer& x509, file_format format, wintls::error_code& ec) {
-  ec = {};
-  try {
-    return x509_to_cert_context(x509, format);
-  } catch (const wintls::system_error& e) {
-    ec = e.code();
-    return cert_context_ptr{};
-  }
-}
+WINTLS_DECL cert_context_ptr x509_to_cert_context(const net::const_buffer& x509, file_format format, wintls::error_code& ec);
 
 /**
  * Import a private key into the default cryptographic provider using the given name.
@@ -125,29 +106,7 @@ inline cert_context_ptr x509_to_cert_context(const net::const_buffer& x509, file
  *
  * @note Currently only RSA keys are supported.
  */
-inline void import_private_key(const net::const_buffer& private_key, file_format format, const std::string& name) {
-  // TODO: Handle ASN.1 DER format
-  WINTLS_VERIFY_MSG(format == file_format::pem, "Only PEM format currently implemented");
-  auto data = detail::crypt_decode_object_ex(net::buffer(detail::crypt_string_to_binary(private_key)), PKCS_PRIVATE_KEY_INFO);
-  auto private_key_info = reinterpret_cast<CRYPT_PRIVATE_KEY_INFO*>(data.data());
-
-  // TODO: Set proper error code instead of asserting
-  WINTLS_VERIFY_MSG(strcmp(private_key_info->Algorithm.pszObjId, szOID_RSA_RSA) == 0, "Only RSA keys supported");
-  auto rsa_private_key = detail::crypt_decode_object_ex(net::buffer(private_key_info->PrivateKey.pbData,
-                                                                    private_key_info->PrivateKey.cbData),
-                                                        PKCS_RSA_PRIVATE_KEY);
-
-  detail::crypt_context ctx(name);
-  detail::crypt_key key;
-  if (!CryptImportKey(ctx.ptr,
-                      rsa_private_key.data(),
-                      static_cast<DWORD>(rsa_private_key.size()),
-                      0,
-                      0,
-                      &key.ptr)) {
-    detail::throw_last_error("CryptImportKey");
-  }
-}
+WINTLS_DECL void import_private_key(const net::const_buffer& private_key, file_format format, const std::string& name);
 
 /**
  * Import a private key into the default cryptographic provider using the given name.
@@ -167,14 +126,7 @@ inline void import_private_key(const net::const_buffer& private_key, file_format
  *
  * @note Currently only RSA keys are supported.
  */
-inline void import_private_key(const net::const_buffer& private_key, file_format format, const std::string& name, wintls::error_code& ec) {
-  ec = {};
-  try {
-    import_private_key(private_key, format, name);
-  } catch (const wintls::system_error& e) {
-    ec = e.code();
-  }
-}
+WINTLS_DECL void import_private_key(const net::const_buffer& private_key, file_format format, const std::string& name, wintls::error_code& ec);
 
 /**
  * Delete a private key from the default cryptographic provider.
@@ -184,13 +136,7 @@ inline void import_private_key(const net::const_buffer& private_key, file_format
  * @throws wintls::system_error Thrown on failure.
  *
  */
-inline void delete_private_key(const std::string& name) {
-  HCRYPTKEY ptr = 0;
-  if (!CryptAcquireContextA(&ptr, name.c_str(), nullptr, PROV_RSA_FULL, CRYPT_DELETEKEYSET)) {
-
-    throw wintls::system_error(static_cast<int>(GetLastError()), wintls::system_category());
-  }
-}
+WINTLS_DECL void delete_private_key(const std::string& name);
 
 /**
  * Delete a private key from the default cryptographic provider.
@@ -200,14 +146,7 @@ inline void delete_private_key(const std::string& name) {
  * @param ec Set to indicate what error occurred, if any.
  *
  */
-inline void delete_private_key(const std::string& name, wintls::error_code& ec) {
-  ec = {};
-  try {
-    delete_private_key(name);
-  } catch (const wintls::system_error& e) {
-    ec = e.code();
-  }
-}
+WINTLS_DECL void delete_private_key(const std::string& name, wintls::error_code& ec);
 
 /**
  * @verbatim embed:rst:leading-asterisk
@@ -231,24 +170,7 @@ inline void delete_private_key(const std::string& name, wintls::error_code& ec)
  *
  * @throws wintls::system_error Thrown on failure.
  */
-inline void assign_private_key(const CERT_CONTEXT* cert, const std::string& name) {
-  // TODO: Move to utility function
-  const auto size = name.size() + 1;
-  auto wname = std::make_unique<WCHAR[]>(size);
-  const auto size_converted = mbstowcs(wname.get(), name.c_str(), size);
-  WINTLS_VERIFY_MSG(size_converted == name.size(), "mbstowcs");
-
-  CRYPT_KEY_PROV_INFO keyProvInfo{};
-  keyProvInfo.pwszContainerName = wname.get();
-  keyProvInfo.pwszProvName = nullptr;
-  keyProvInfo.dwFlags = CERT_SET_KEY_PROV_HANDLE_PROP_ID | CERT_SET_KEY_CONTEXT_PROP_ID;
-  keyProvInfo.dwProvType = PROV_RSA_FULL;
-  keyProvInfo.dwKeySpec = AT_KEYEXCHANGE;
-
-  if (!CertSetCertificateContextProperty(cert, CERT_KEY_PROV_INFO_PROP_ID, 0, &keyProvInfo)) {
-    detail::throw_last_error("CertSetCertificateContextProperty");
-  }
-}
+WINTLS_DECL void assign_private_key(const CERT_CONTEXT* cert, const std::string& name);
 
 /**
  * @verbatim embed:rst:leading-asterisk
@@ -272,15 +194,12 @@ inline void assign_private_key(const CERT_CONTEXT* cert, const std::string& name
  *
  * @param ec Set to indicate what error occurred, if any.
  */
-inline void assign_private_key(const CERT_CONTEXT* cert, const std::string& name, wintls::error_code& ec) {
-  ec = {};
-  try {
-    assign_private_key(cert, name);
-  } catch (const wintls::system_error& e) {
-    ec = e.code();
-  }
-}
+WINTLS_DECL void assign_private_key(const CERT_CONTEXT* cert, const std::string& name, wintls::error_code& ec);
 
 } // namespace wintls
 
+#if WINTLS_HEADER_ONLY
+#include <wintls/impl/certificate.ipp>
+#endif // WINTLS_HEADER_ONLY
+
 #endif // WINTLS_CERTIFICATE_HPP
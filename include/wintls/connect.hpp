@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_CONNECT_HPP
+#define WINTLS_CONNECT_HPP
+
+#include <wintls/stream.hpp>
+
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/happy_eyeballs.hpp>
+
+#include <chrono>
+#include <vector>
+
+namespace wintls {
+
+/** Start an asynchronous operation connecting a stream to one of a
+ * sequence of endpoints and performing a client handshake.
+ *
+ * Connection attempts are raced as described in RFC 8305 (Happy
+ * Eyeballs Version 2). The endpoints are ordered alternating between
+ * IPv6 and IPv4, starting with the family of the first endpoint, and
+ * a new connection attempt is started every time the attempt delay
+ * expires or as soon as an earlier attempt fails.
+ *
+ * The TLS handshake is performed on the first connection established,
+ * all other attempts are cancelled and their sockets closed.
+ *
+ * The server hostname, if any, must be set using @ref
+ * stream::set_server_hostname before calling this function.
+ *
+ * @param s The stream to connect. The next layer must be a socket,
+ * which is replaced by the connected socket.
+ * @param endpoints A sequence of endpoints, like the result of a
+ * resolve operation.
+ * @param attempt_delay The time to wait for a connection attempt
+ * before starting the next one. RFC 8305 recommends 250 milliseconds.
+ * @param handler The handler to be called when the operation
+ * completes. The equivalent function signature of the handler must
+ * be:
+ * @code
+ * void handler(
+ *     wintls::error_code,                     // Result of operation.
+ *     typename NextLayer::endpoint_type       // The endpoint connected to, default constructed on failure.
+ * );
+ * @endcode
+ */
+template <class NextLayer, class EndpointSequence, class CompletionToken>
+auto async_connect_and_handshake(stream<NextLayer>& s,
+                                 const EndpointSequence& endpoints,
+                                 std::chrono::steady_clock::duration attempt_delay,
+                                 CompletionToken&& handler) {
+  using op_type = detail::async_connect_and_handshake<stream<NextLayer>>;
+  std::vector<typename op_type::endpoint_type> candidates;
+  for (const auto& endpoint : endpoints) {
+    candidates.push_back(endpoint);
+  }
+  return net::async_compose<CompletionToken, void(wintls::error_code, typename op_type::endpoint_type)>(
+      op_type{s, std::move(candidates), attempt_delay}, handler, s);
+}
+
+/** Start an asynchronous operation connecting a stream to one of a
+ * sequence of endpoints and performing a client handshake.
+ *
+ * Same as above using the connection attempt delay of 250
+ * milliseconds recommended by RFC 8305.
+ *
+ * @param s The stream to connect.
+ * @param endpoints A sequence of endpoints, like the result of a
+ * resolve operation.
+ * @param handler The handler to be called when the operation
+ * completes. The equivalent function signature of the handler must
+ * be:
+ * @code
+ * void handler(
+ *     wintls::error_code,                     // Result of operation.
+ *     typename NextLayer::endpoint_type       // The endpoint connected to, default constructed on failure.
+ * );
+ * @endcode
+ */
+template <class NextLayer, class EndpointSequence, class CompletionToken>
+auto async_connect_and_handshake(stream<NextLayer>& s,
+                                 const EndpointSequence& endpoints,
+                                 CompletionToken&& handler) {
+  return async_connect_and_handshake(s, endpoints, std::chrono::milliseconds(250),
+                                     std::forward<CompletionToken>(handler));
+}
+
+} // namespace wintls
+
+#endif // WINTLS_CONNECT_HPP
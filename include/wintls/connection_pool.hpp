@@ -0,0 +1,195 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_CONNECTION_POOL_HPP
+#define WINTLS_CONNECTION_POOL_HPP
+
+#include <wintls/context.hpp>
+#include <wintls/stream.hpp>
+
+#include <wintls/detail/async_pool_connect.hpp>
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/idle_connection.hpp>
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace wintls {
+
+/** Identifies the connections which can be used interchangeably in a
+ * @ref connection_pool.
+ */
+struct connection_pool_key {
+  /// The host to connect to.
+  std::string host;
+  /// The port or service name to connect to.
+  std::string port;
+  /// The SNI hostname used in the handshake and for verifying the server certificate.
+  std::string server_hostname;
+  /// The @ref context used for the connections.
+  context* ctx;
+};
+
+inline bool operator<(const connection_pool_key& lhs, const connection_pool_key& rhs) {
+  return std::tie(lhs.host, lhs.port, lhs.server_hostname, lhs.ctx) <
+         std::tie(rhs.host, rhs.port, rhs.server_hostname, rhs.ctx);
+}
+
+/** Pool of established client streams kept alive for reuse.
+ *
+ * Streams are handed out for a @ref connection_pool_key and returned
+ * to the pool when the caller is done with them, so later requests to
+ * the same host can skip both connecting and the TLS handshake.
+ *
+ * Idle streams are checked before being handed out. A stream which
+ * has received anything while idle, like a TLS close_notify alert,
+ * or where the peer has closed the connection is discarded. For
+ * socket based next layers this is done by peeking at the socket
+ * without blocking, other next layers are only checked for data
+ * already buffered by the stream.
+ *
+ * When new connections are needed, enabling @ref
+ * context::reuse_credentials on the context used makes the handshakes
+ * resume previous TLS sessions with the same host.
+ *
+ * All member functions are thread safe.
+ *
+ * @tparam NextLayer The type of the next layer of the pooled streams.
+ */
+template <class NextLayer>
+class connection_pool {
+public:
+  /// The type of the pooled streams.
+  using stream_type = stream<NextLayer>;
+
+  /// Owning pointer to a stream handed out by the pool.
+  using stream_ptr = std::unique_ptr<stream_type>;
+
+  /** Construct a connection pool.
+   *
+   * @param max_idle_per_key The maximum number of idle streams kept
+   * for each @ref connection_pool_key.
+   */
+  explicit connection_pool(std::size_t max_idle_per_key = 8)
+    : max_idle_per_key_(max_idle_per_key) {
+  }
+
+  connection_pool(const connection_pool&) = delete;
+  connection_pool& operator=(const connection_pool&) = delete;
+
+  /** Take an idle stream from the pool.
+   *
+   * The most recently returned stream is handed out first. Idle
+   * streams which are no longer usable are discarded.
+   *
+   * @param key The @ref connection_pool_key to get a stream for.
+   *
+   * @returns An established stream, or an empty pointer if no usable
+   * idle stream was available.
+   */
+  stream_ptr try_acquire(const connection_pool_key& key) {
+    std::vector<stream_ptr> discarded;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = idle_.find(key);
+    if (it == idle_.end()) {
+      return nullptr;
+    }
+    auto& streams = it->second;
+    while (!streams.empty()) {
+      auto s = std::move(streams.back());
+      streams.pop_back();
+      if (is_reusable(*s)) {
+        return s;
+      }
+      discarded.push_back(std::move(s));
+    }
+    return nullptr;
+  }
+
+  /** Return a stream to the pool.
+   *
+   * The stream is kept for reuse unless the maximum number of idle
+   * streams for the key has been reached, it has been aborted, it
+   * has unread data or a read ahead has not been stopped, in which
+   * case it is destroyed.
+   *
+   * @param key The @ref connection_pool_key the stream was acquired for.
+   * @param s The stream to return.
+   */
+  void release(const connection_pool_key& key, stream_ptr s) {
+    if (!s || !is_reusable(*s)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& streams = idle_[key];
+    if (streams.size() < max_idle_per_key_) {
+      streams.push_back(std::move(s));
+    }
+  }
+
+  /** Start an asynchronous operation getting an established stream.
+   *
+   * Completes with an idle stream from the pool if one is usable,
+   * otherwise the host of the key is resolved and connected to, and
+   * a client handshake is performed on a new stream.
+   *
+   * @param key The @ref connection_pool_key to get a stream for.
+   * @param executor The executor used for new streams.
+   * @param handler The handler to be called when the operation
+   * completes. The equivalent function signature of the handler must
+   * be:
+   * @code
+   * void handler(
+   *     wintls::error_code,                          // Result of operation.
+   *     std::unique_ptr<wintls::stream<NextLayer>>   // The stream, empty on failure.
+   * );
+   * @endcode
+   *
+   * @note Only supported when the next layer is a socket.
+   */
+  template <class Executor, class CompletionToken>
+  auto async_acquire(const connection_pool_key& key, const Executor& executor, CompletionToken&& handler) {
+    return net::async_compose<CompletionToken, void(wintls::error_code, stream_ptr)>(
+        detail::async_pool_connect<stream_type>{executor, try_acquire(key), *key.ctx, key.host, key.port, key.server_hostname},
+        handler, executor);
+  }
+
+  /** Get the number of idle streams in the pool for a key.
+   *
+   * @param key The @ref connection_pool_key to count idle streams for.
+   */
+  std::size_t idle_count(const connection_pool_key& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = idle_.find(key);
+    return it == idle_.end() ? 0 : it->second.size();
+  }
+
+  /// Destroy all idle streams in the pool.
+  void clear() {
+    std::map<connection_pool_key, std::vector<stream_ptr>> discarded;
+    std::lock_guard<std::mutex> lock(mutex_);
+    discarded.swap(idle_);
+  }
+
+private:
+  static bool is_reusable(stream_type& s) {
+    return detail::idle_stream_reusable(s.sspi_stream_.get(), s.next_layer());
+  }
+
+  mutable std::mutex mutex_;
+  std::map<connection_pool_key, std::vector<stream_ptr>> idle_;
+  std::size_t max_idle_per_key_;
+};
+
+} // namespace wintls
+
+#endif // WINTLS_CONNECTION_POOL_HPP
@@ -0,0 +1,312 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_CONNECTION_RESERVOIR_HPP
+#define WINTLS_CONNECTION_RESERVOIR_HPP
+
+#include <wintls/connection_pool.hpp>
+#include <wintls/stream.hpp>
+
+#include <wintls/detail/async_pool_connect.hpp>
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/idle_connection.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace wintls {
+
+/** Keeps a number of spare, already established client streams ready.
+ *
+ * Unlike the @ref connection_pool, which only holds streams returned
+ * after use, the reservoir connects and handshakes streams up front
+ * and replaces every stream taken from it in the background. This
+ * takes connection setup off the critical path for bursty traffic.
+ *
+ * Spare streams are retired with a graceful TLS shutdown when they
+ * have been idle for a given time, which should be shorter than the
+ * idle timeout of the server, and replaced with new ones. Spare
+ * streams closed by the server are detected and replaced when taken
+ * or when another spare stream is retired.
+ *
+ * @ref try_pop and @ref available can be called from any thread.
+ * Taking a spare stream doesn't wait for the background work, but
+ * posts the establishing of a replacement to the executor. The
+ * background work is serialized on a strand of the executor given on
+ * construction, while the streams established use the executor
+ * itself.
+ *
+ * @tparam NextLayer The type of the next layer of the streams. Must
+ * be a socket.
+ */
+template <class NextLayer>
+class connection_reservoir {
+public:
+  /// The type of the spare streams.
+  using stream_type = stream<NextLayer>;
+
+  /// Owning pointer to a stream taken from the reservoir.
+  using stream_ptr = std::unique_ptr<stream_type>;
+
+  /// The type of the executor used for the background work.
+  using executor_type = typename NextLayer::executor_type;
+
+  /// The clock used for the idle time of the spare streams.
+  using clock_type = std::chrono::steady_clock;
+
+  /** Construct a reservoir.
+   *
+   * No connections are made until @ref start is called.
+   *
+   * @param executor The executor used for establishing and retiring
+   * streams.
+   * @param key The @ref connection_pool_key describing the host to
+   * connect to and the context to use.
+   * @param spares The number of spare streams to keep.
+   * @param max_idle The time after which an unused spare stream is
+   * retired.
+   */
+  connection_reservoir(const executor_type& executor,
+                       const connection_pool_key& key,
+                       std::size_t spares,
+                       clock_type::duration max_idle)
+    : state_(std::make_shared<state>(executor, key, spares, max_idle)) {
+  }
+
+  connection_reservoir(const connection_reservoir&) = delete;
+  connection_reservoir& operator=(const connection_reservoir&) = delete;
+
+  /// Destroys the spare streams and stops the background work.
+  ~connection_reservoir() {
+    state_->stop();
+  }
+
+  /// Start establishing spare streams in the background.
+  void start() {
+    auto s = state_;
+    net::post(s->strand, [s]() {
+      s->replenish();
+    });
+  }
+
+  /** Take a spare stream from the reservoir.
+   *
+   * A replacement is established in the background.
+   *
+   * @returns An established stream, or an empty pointer if no spare
+   * stream is ready.
+   */
+  stream_ptr try_pop() {
+    return state_->pop();
+  }
+
+  /// The number of spare streams ready to be taken.
+  std::size_t available() const {
+    return state_->filled;
+  }
+
+private:
+  struct spare {
+    stream_ptr stream;
+    clock_type::time_point created;
+  };
+
+  // Shared with the background operations, which may outlive the
+  // reservoir itself. Everything but pop and clear runs on the strand.
+  struct state : std::enable_shared_from_this<state> {
+    state(const executor_type& ex, const connection_pool_key& k, std::size_t spares, clock_type::duration idle)
+      : executor(ex)
+      , strand(net::make_strand(ex))
+      , key(k)
+      , slots(spares)
+      , max_idle(idle)
+      , timer(strand) {
+      for (auto& slot : slots) {
+        slot.store(nullptr);
+      }
+    }
+
+    ~state() {
+      clear();
+    }
+
+    stream_ptr pop() {
+      for (auto& slot : slots) {
+        std::unique_ptr<spare> taken{slot.exchange(nullptr)};
+        if (!taken) {
+          continue;
+        }
+        --filled;
+        post_replenish();
+        if (usable(*taken)) {
+          return std::move(taken->stream);
+        }
+      }
+      return nullptr;
+    }
+
+    void replenish() {
+      while (!stopped && filled + connecting < slots.size()) {
+        ++connecting;
+        auto handler = net::bind_executor(strand, [self = this->shared_from_this()](wintls::error_code ec, stream_ptr s) {
+          --self->connecting;
+          if (ec) {
+            return self->retry_later();
+          }
+          self->store(std::move(s));
+        });
+        net::async_compose<decltype(handler), void(wintls::error_code, stream_ptr)>(
+          detail::async_pool_connect<stream_type>{executor, nullptr, *key.ctx, key.host, key.port, key.server_hostname},
+          handler,
+          executor);
+      }
+    }
+
+    void post_replenish() {
+      auto self = this->shared_from_this();
+      net::post(strand, [self]() {
+        self->replenish();
+      });
+    }
+
+    void retry_later() {
+      if (stopped) {
+        return;
+      }
+      // Don't keep hammering an unavailable host
+      auto retry_timer = std::make_shared<net::steady_timer>(strand, std::chrono::seconds(1));
+      auto self = this->shared_from_this();
+      retry_timer->async_wait([self, retry_timer](const wintls::error_code&) {
+        self->replenish();
+      });
+    }
+
+    void store(stream_ptr s) {
+      if (stopped) {
+        return shut_down(std::move(s));
+      }
+      const auto created = clock_type::now();
+      auto left = put(std::make_unique<spare>(spare{std::move(s), created}));
+      if (left) {
+        return shut_down(std::move(left->stream));
+      }
+      schedule_retire(created + max_idle);
+    }
+
+    // Put the spare stream in the first empty slot, returning it if
+    // there is none. The count is increased first, so it never drops
+    // below the number of spares in the slots when popped right away.
+    std::unique_ptr<spare> put(std::unique_ptr<spare> sp) {
+      ++filled;
+      for (auto& slot : slots) {
+        spare* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, sp.get())) {
+          sp.release();
+          return nullptr;
+        }
+      }
+      --filled;
+      return sp;
+    }
+
+    // Gracefully close a stream not kept as a spare
+    static void shut_down(stream_ptr s) {
+      auto& closing = *s;
+      closing.async_shutdown([s = std::move(s)](const wintls::error_code&) {});
+    }
+
+    // Retire spare streams when the first of them expires, unless
+    // waiting for an earlier expiry already
+    void schedule_retire(clock_type::time_point expiry) {
+      if (stopped || expiry >= retire_at) {
+        return;
+      }
+      retire_at = expiry;
+      timer.expires_at(expiry);
+      auto self = this->shared_from_this();
+      timer.async_wait([self](const wintls::error_code& ec) {
+        if (!ec) {
+          self->retire_at = clock_type::time_point::max();
+          self->retire();
+        }
+      });
+    }
+
+    // Replace spare streams which have been idle for too long or are
+    // no longer usable, and wait for the next one kept to expire
+    void retire() {
+      const auto now = clock_type::now();
+      auto next_expiry = clock_type::time_point::max();
+      for (auto& slot : slots) {
+        // Take the spare out while checking it, as it could otherwise
+        // be popped and destroyed by another thread in the meantime
+        std::unique_ptr<spare> taken{slot.exchange(nullptr)};
+        if (!taken) {
+          continue;
+        }
+        --filled;
+        const bool alive = usable(*taken);
+        if (alive && now - taken->created < max_idle) {
+          const auto expiry = taken->created + max_idle;
+          taken = put(std::move(taken));
+          if (!taken) {
+            next_expiry = std::min(next_expiry, expiry);
+            continue;
+          }
+        }
+        if (alive) {
+          shut_down(std::move(taken->stream));
+        }
+      }
+      schedule_retire(next_expiry);
+      replenish();
+    }
+
+    static bool usable(spare& sp) {
+      return sp.stream && detail::idle_stream_reusable(sp.stream->sspi_stream_.get(), sp.stream->next_layer());
+    }
+
+    void stop() {
+      stopped = true;
+      net::post(strand, [self = this->shared_from_this()]() {
+        self->timer.cancel();
+      });
+      clear();
+    }
+
+    void clear() {
+      for (auto& slot : slots) {
+        std::unique_ptr<spare> taken{slot.exchange(nullptr)};
+        if (taken) {
+          --filled;
+        }
+      }
+    }
+
+    executor_type executor;
+    net::strand<executor_type> strand;
+    connection_pool_key key;
+    std::vector<std::atomic<spare*>> slots;
+    clock_type::duration max_idle;
+    net::steady_timer timer;
+    // When the timer expires, only used on the strand
+    clock_type::time_point retire_at = clock_type::time_point::max();
+    std::atomic<std::size_t> filled{0};
+    std::atomic<std::size_t> connecting{0};
+    std::atomic<bool> stopped{false};
+  };
+
+  std::shared_ptr<state> state_;
+};
+
+} // namespace wintls
+
+#endif // WINTLS_CONNECTION_RESERVOIR_HPP
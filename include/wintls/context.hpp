@@ -8,17 +8,26 @@
 #ifndef WINTLS_CONTEXT_HPP
 #define WINTLS_CONTEXT_HPP
 
+#include <wintls/context_statistics.hpp>
 #include <wintls/method.hpp>
 
+#include <wintls/detail/async_drain.hpp>
 #include <wintls/detail/config.hpp>
 #include <wintls/detail/context_certificates.hpp>
+#include <wintls/detail/context_counters.hpp>
+#include <wintls/detail/credentials_cache.hpp>
+#include <wintls/detail/stream_registry.hpp>
 
+#include <chrono>
+#include <memory>
 #include <string>
 
 namespace wintls {
 
 namespace detail {
 class sspi_handshake;
+class sspi_stream;
+class sspi_datagram;
 }
 
 class context {
@@ -28,7 +37,9 @@ public:
    * @param connection_method The @ref method to use for connections.
    */
   explicit context(method connection_method)
-    : method_(connection_method)
+    : counters_(std::make_unique<detail::context_counters>())
+    , registry_(std::make_unique<detail::stream_registry>())
+    , method_(connection_method)
     , verify_server_certificate_(false) {
   }
 
@@ -75,6 +86,44 @@ public:
     verify_server_certificate_ = verify;
   }
 
+  /** Enables/disables sharing credentials between streams
+   *
+   * By default each @ref stream acquires its own Schannel credentials
+   * when performing a handshake. Enabling this makes all streams
+   * using this context share the same credentials.
+   *
+   * Schannel caches TLS sessions per credentials, so this allows
+   * clients reconnecting to the same server (using the same server
+   * hostname) to resume the previous session instead of doing a full
+   * handshake. It also avoids the cost of acquiring new credentials
+   * for each connection.
+   *
+   * Setting a new certificate using @ref use_certificate releases
+   * the shared credentials, so new streams will acquire new ones.
+   *
+   * @param reuse True if credentials should be shared between streams.
+   */
+  void reuse_credentials(bool reuse) {
+    if (reuse && !credentials_cache_) {
+      credentials_cache_ = std::make_unique<detail::credentials_cache>();
+    } else if (!reuse) {
+      credentials_cache_.reset();
+    }
+  }
+
+  /** Track the streams using the context for draining.
+   *
+   * Registers each stream constructed afterwards with the context, so
+   * it can be shut down by @ref async_drain. Disabled by default, as
+   * registering a stream takes a lock and an allocation which only
+   * contexts being drained need to pay for.
+   *
+   * @param track True if streams should be tracked.
+   */
+  void track_streams(bool track) {
+    registry_->enable(track);
+  }
+
   /** Use the default operating system certificates
    *
    * This function may be used to verify the server certficates
@@ -109,6 +158,9 @@ public:
    */
   void use_certificate(const CERT_CONTEXT* cert) {
     ctx_certs_.use_certificate(cert);
+    if (credentials_cache_) {
+      credentials_cache_->clear();
+    }
   }
 
   /** Set the certificate to use when operating as a server
@@ -128,12 +180,69 @@ public:
    */
   void use_certificate(const CERT_CONTEXT* cert, wintls::error_code& ec) {
     try {
-      ctx_certs_.use_certificate(cert);
+      use_certificate(cert);
     } catch (const wintls::system_error& e) {
       ec = e.code();
     }
   }
 
+  /** Get statistics about the streams using the context.
+   *
+   * Counts graceful shutdowns separately from abortive closes using
+   * @ref stream::abort, and the progress of the latest drain started
+   * with @ref async_drain.
+   *
+   * May be called from any thread.
+   */
+  context_statistics statistics() const {
+    return counters_->snapshot();
+  }
+
+  /** Start an asynchronous operation gracefully shutting down all
+   * streams using the context.
+   *
+   * Performs a TLS shutdown on each stream tracked by the context
+   * using @ref track_streams when the operation is started, with at
+   * most the given number of shutdowns in flight at a time to avoid
+   * a burst of writes when draining a large number of connections,
+   * like when a server is stopped. The progress can be followed using
+   * @ref statistics.
+   *
+   * Streams not shut down when the deadline is reached have their
+   * next layer closed, which makes any outstanding operations on them
+   * complete with an error. The streams themselves are still owned by
+   * the application and must be destroyed as usual.
+   *
+   * Each stream is operated on using its own executor, so the streams
+   * must only be used from their executors while the operation is in
+   * progress and no other write or shutdown must be outstanding on
+   * them. Reads may be outstanding, for instance waiting for the peer
+   * to close the connection. The context must outlive the operation.
+   *
+   * @param ex The executor used for the deadline timer and for keeping
+   * the operation alive.
+   * @param deadline The time at which the remaining streams are
+   * closed.
+   * @param concurrency The maximum number of shutdowns in flight.
+   * @param handler The handler to be called when all streams have
+   * been shut down or closed. The equivalent function signature of the
+   * handler must be:
+   * @code
+   * void handler(
+   *     wintls::error_code // net::error::timed_out if the deadline was reached, or
+   *                        // net::error::operation_not_supported if streams aren't tracked.
+   * );
+   * @endcode
+   */
+  template <class Executor, class CompletionToken>
+  auto async_drain(const Executor& ex,
+                   std::chrono::steady_clock::time_point deadline,
+                   std::size_t concurrency,
+                   CompletionToken&& handler) {
+    return net::async_initiate<CompletionToken, void(wintls::error_code)>(
+        detail::drain_initiation{}, handler, ex, registry_.get(), counters_.get(), deadline, concurrency);
+  }
+
 private:
   DWORD verify_certificate(const CERT_CONTEXT* cert, const std::string& server_hostname, bool check_revocation) {
     if (!verify_server_certificate_) {
@@ -147,8 +256,13 @@ private:
   }
 
   friend class detail::sspi_handshake;
+  friend class detail::sspi_stream;
+  friend class detail::sspi_datagram;
 
   detail::context_certificates ctx_certs_;
+  std::unique_ptr<detail::credentials_cache> credentials_cache_;
+  std::unique_ptr<detail::context_counters> counters_;
+  std::unique_ptr<detail::stream_registry> registry_;
   method method_;
   bool verify_server_certificate_;
 };
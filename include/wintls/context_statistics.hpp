@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_CONTEXT_STATISTICS_HPP
+#define WINTLS_CONTEXT_STATISTICS_HPP
+
+#include <cstdint>
+
+namespace wintls {
+
+/** Statistics about the streams and credentials of a @ref context.
+ *
+ * The shutdown and abort counters describe how the streams using the
+ * context have been closed.
+ *
+ * The drain counters describe the latest drain started with
+ * context::async_drain and can be used to follow its progress.
+ */
+struct context_statistics {
+  /// The number of streams shut down gracefully by sending a TLS close_notify alert.
+  std::uint64_t shutdowns;
+  /// The number of streams closed abortively using stream::abort.
+  std::uint64_t aborts;
+  /// The number of streams currently using the context.
+  std::uint64_t streams;
+  /// The number of streams being drained.
+  std::uint64_t drain_streams;
+  /// The number of drained streams shut down gracefully.
+  std::uint64_t drain_shutdowns;
+  /// The number of drained streams where the shutdown failed.
+  std::uint64_t drain_failures;
+  /// The number of drained streams closed at the deadline.
+  std::uint64_t drain_aborts;
+  /** The number of credentials acquired, which is only done once per
+   * usage while context::reuse_credentials is enabled.
+   */
+  std::uint64_t credentials_acquired;
+};
+
+} // namespace wintls
+
+#endif // WINTLS_CONTEXT_STATISTICS_HPP
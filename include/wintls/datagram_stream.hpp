@@ -0,0 +1,406 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DATAGRAM_STREAM_HPP
+#define WINTLS_DATAGRAM_STREAM_HPP
+
+#include <wintls/error.hpp>
+#include <wintls/handshake_type.hpp>
+
+#include <wintls/detail/async_datagram_handshake.hpp>
+#include <wintls/detail/async_datagram_receive.hpp>
+#include <wintls/detail/async_datagram_send.hpp>
+#include <wintls/detail/sspi_datagram.hpp>
+
+#ifdef WINTLS_USE_STANDALONE_ASIO
+#include <asio/compose.hpp>
+#else // WINTLS_USE_STANDALONE_ASIO
+#include <boost/asio/compose.hpp>
+#endif // !WINTLS_USE_STANDALONE_ASIO
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace wintls {
+
+/** Provides datagram-oriented functionality using DTLS with Windows SSPI/Schannel.
+ *
+ * The datagram_stream class template secures a connected datagram
+ * socket, like a UDP socket, using DTLS. Each send is encrypted as a
+ * single DTLS record sent as a single datagram, and each receive
+ * returns the data of a single datagram. As with plain datagrams,
+ * data may be lost, duplicated or reordered on the way, but
+ * duplicated, replayed and corrupted datagrams are discarded.
+ *
+ * The handshake retransmits the last handshake messages sent when no
+ * reply arrives in time, doubling the timeout every time.
+ *
+ * The @ref context used must be created with one of the DTLS methods,
+ * like @ref method::dtlsv12_client or @ref method::dtlsv12_server.
+ *
+ * @tparam NextLayer The type representing the next layer, to which
+ * datagrams will be sent and received during operations. Must be
+ * connected to the peer and provide `send`, `receive`, `async_send`,
+ * `async_receive` and `cancel` like `net::ip::udp::socket`.
+ */
+template<class NextLayer>
+class datagram_stream {
+public:
+  /// The type of the next layer.
+  using next_layer_type = typename std::remove_reference<NextLayer>::type;
+
+  /// The type of the executor associated with the object.
+  using executor_type = typename next_layer_type::executor_type;
+
+  /** Construct a datagram stream.
+   *
+   *  @param arg The argument to be passed to initialise the
+   *  underlying datagram socket.
+   *  @param ctx The wintls @ref context to be used for the stream.
+   */
+  template <class Arg>
+  datagram_stream(Arg&& arg, context& ctx)
+    : next_layer_(std::forward<Arg>(arg))
+    , sspi_datagram_(std::make_unique<detail::sspi_datagram>(ctx)) {
+  }
+
+  datagram_stream(datagram_stream&& other) = default;
+  datagram_stream& operator=(datagram_stream&& other) = default;
+
+  /** Get the executor associated with the object.
+   *
+   * @return A copy of the executor that stream will use to dispatch
+   * handlers.
+   */
+  executor_type get_executor() {
+    return next_layer_.get_executor();
+  }
+
+  /** Get a reference to the next layer.
+   *
+   * @return A reference to the next layer, the connected datagram
+   * socket.
+   */
+  const next_layer_type& next_layer() const {
+    return next_layer_;
+  }
+
+  /** Get a reference to the next layer.
+   *
+   * @return A reference to the next layer, the connected datagram
+   * socket.
+   */
+  next_layer_type& next_layer() {
+    return next_layer_;
+  }
+
+  /** Set SNI hostname
+   *
+   * Sets the SNI hostname the client will use for requesting and
+   * validating the server certificate.
+   *
+   * @param hostname The hostname to use in certificate validation
+   */
+  void set_server_hostname(const std::string& hostname) {
+    sspi_datagram_->handshake.set_server_hostname(hostname);
+  }
+
+  /** Set the maximum size of the datagrams sent.
+   *
+   * Limits the data sent in a single datagram, so the datagram
+   * including the DTLS record overhead fits in the path MTU without
+   * being fragmented. Schannel fragments the handshake messages after
+   * the MTU as well. The default of 1200 bytes fits on most paths
+   * over both IPv4 and IPv6.
+   *
+   * @param mtu The path MTU minus the size of the IP and UDP headers.
+   * @param ec Set to indicate what error occurred, if any.
+   */
+  void set_mtu(std::size_t mtu, wintls::error_code& ec) {
+    sspi_datagram_->set_mtu(mtu, ec);
+  }
+
+  /** Set the maximum size of the datagrams sent.
+   *
+   * Limits the data sent in a single datagram, so the datagram
+   * including the DTLS record overhead fits in the path MTU without
+   * being fragmented. Schannel fragments the handshake messages after
+   * the MTU as well. The default of 1200 bytes fits on most paths
+   * over both IPv4 and IPv6.
+   *
+   * @param mtu The path MTU minus the size of the IP and UDP headers.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   */
+  void set_mtu(std::size_t mtu) {
+    wintls::error_code ec{};
+    set_mtu(mtu, ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+  }
+
+  /** Set the handshake retransmission timeout.
+   *
+   * The time to wait for a reply during the handshake before
+   * retransmitting, which doubles with every retransmission. The
+   * handshake fails with `net::error::timed_out` after six
+   * retransmissions without a reply. Defaults to one second.
+   *
+   * @param timeout The initial retransmission timeout.
+   */
+  void set_retransmit_timeout(std::chrono::steady_clock::duration timeout) {
+    sspi_datagram_->retransmit_timeout = timeout;
+  }
+
+  /** Get the largest amount of data which can be sent at once.
+   *
+   * The size of the data which fits in a single datagram of the size
+   * set using @ref set_mtu. Only available after the handshake.
+   *
+   * @param ec Set to indicate what error occurred, if any.
+   */
+  std::size_t max_message_size(wintls::error_code& ec) {
+    return sspi_datagram_->max_message_size(ec);
+  }
+
+  /** Get the largest amount of data which can be sent at once.
+   *
+   * The size of the data which fits in a single datagram of the size
+   * set using @ref set_mtu. Only available after the handshake.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   */
+  std::size_t max_message_size() {
+    wintls::error_code ec{};
+    const auto size = max_message_size(ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+    return size;
+  }
+
+  /** Start an asynchronous DTLS handshake.
+   *
+   * @param type The @ref handshake_type to be performed, i.e. client
+   * or server.
+   * @param handler The handler to be called when the operation
+   * completes. The equivalent function signature of the handler must
+   * be:
+   * @code
+   * void handler(
+   *     wintls::error_code // Result of operation.
+   * );
+   * @endcode
+   */
+  template <class CompletionToken>
+  auto async_handshake(handshake_type type, CompletionToken&& handler) {
+    return net::async_compose<CompletionToken, void(wintls::error_code)>(
+        detail::async_datagram_handshake<next_layer_type>{next_layer_, *sspi_datagram_, type}, handler);
+  }
+
+  /** Send data as a single datagram.
+   *
+   * @param buffers The data to be sent. Must not be larger than @ref
+   * max_message_size.
+   * @param ec Set to indicate what error occurred, if any.
+   *
+   * @returns The number of bytes sent.
+   */
+  template <class ConstBufferSequence>
+  std::size_t send(const ConstBufferSequence& buffers, wintls::error_code& ec) {
+    const auto record = sspi_datagram_->encrypt(buffers, ec);
+    if (ec) {
+      return 0;
+    }
+    next_layer_.send(net::buffer(record), 0, ec);
+    return ec ? 0 : net::buffer_size(buffers);
+  }
+
+  /** Send data as a single datagram.
+   *
+   * @param buffers The data to be sent. Must not be larger than @ref
+   * max_message_size.
+   *
+   * @returns The number of bytes sent.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   */
+  template <class ConstBufferSequence>
+  std::size_t send(const ConstBufferSequence& buffers) {
+    wintls::error_code ec{};
+    const auto size = send(buffers, ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+    return size;
+  }
+
+  /** Start an asynchronous send of data as a single datagram.
+   *
+   * @param buffers The data to be sent. Must not be larger than @ref
+   * max_message_size. The data is copied before this function
+   * returns, so the buffers need not remain valid. Several sends may
+   * be outstanding at a time.
+   * @param handler The handler to be called when the operation
+   * completes. The equivalent function signature of the handler must
+   * be:
+   * @code
+   * void handler(
+   *     wintls::error_code, // Result of operation.
+   *     std::size_t         // Number of bytes sent.
+   * );
+   * @endcode
+   */
+  template <class ConstBufferSequence, class CompletionToken>
+  auto async_send(const ConstBufferSequence& buffers, CompletionToken&& handler) {
+    return net::async_compose<CompletionToken, void(wintls::error_code, std::size_t)>(
+        detail::async_datagram_send<next_layer_type>{next_layer_, buffers, *sspi_datagram_}, handler);
+  }
+
+  /** Receive the data of a single datagram.
+   *
+   * Blocks until a datagram with data from the peer has been
+   * received. If the buffers are too small for the data, as much as
+   * fits is returned and `ec` is set to `net::error::message_size`.
+   *
+   * @param buffers The buffers into which the data will be received.
+   * @param ec Set to indicate what error occurred, if any.
+   *
+   * @returns The number of bytes received.
+   */
+  template <class MutableBufferSequence>
+  std::size_t receive(const MutableBufferSequence& buffers, wintls::error_code& ec) {
+    for (;;) {
+      const auto length = next_layer_.receive(sspi_datagram_->receive_buffer(), 0, ec);
+      if (ec) {
+        return 0;
+      }
+      std::size_t size_decrypted = 0;
+      const auto state = sspi_datagram_->decrypt(length, buffers, size_decrypted, ec);
+      if (state != detail::sspi_datagram::decrypt_state::discarded) {
+        return size_decrypted;
+      }
+      if (sspi_datagram_->received_handshake(length)) {
+        // The peer hasn't received our last handshake flight
+        for (const auto& datagram : sspi_datagram_->flight()) {
+          next_layer_.send(net::buffer(datagram), 0, ec);
+          if (ec) {
+            return 0;
+          }
+        }
+      }
+    }
+  }
+
+  /** Receive the data of a single datagram.
+   *
+   * Blocks until a datagram with data from the peer has been
+   * received.
+   *
+   * @param buffers The buffers into which the data will be received.
+   *
+   * @returns The number of bytes received.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   */
+  template <class MutableBufferSequence>
+  std::size_t receive(const MutableBufferSequence& buffers) {
+    wintls::error_code ec{};
+    const auto size = receive(buffers, ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+    return size;
+  }
+
+  /** Start an asynchronous receive of the data of a single datagram.
+   *
+   * Completes when a datagram with data from the peer has been
+   * received. If the buffers are too small for the data, as much as
+   * fits is returned together with `net::error::message_size`.
+   *
+   * @param buffers The buffers into which the data will be
+   * received. Ownership of the underlying buffers is retained by the
+   * caller, which must guarantee that they remain valid until the
+   * handler is called.
+   * @param handler The handler to be called when the operation
+   * completes. The equivalent function signature of the handler must
+   * be:
+   * @code
+   * void handler(
+   *     wintls::error_code, // Result of operation.
+   *     std::size_t         // Number of bytes received.
+   * );
+   * @endcode
+   */
+  template <class MutableBufferSequence, class CompletionToken>
+  auto async_receive(const MutableBufferSequence& buffers, CompletionToken&& handler) {
+    return net::async_compose<CompletionToken, void(wintls::error_code, std::size_t)>(
+        detail::async_datagram_receive<next_layer_type, MutableBufferSequence>{next_layer_, buffers, *sspi_datagram_}, handler);
+  }
+
+  /** Send a DTLS close_notify alert to the peer.
+   *
+   * As datagrams may be lost, the peer can't rely on receiving it.
+   *
+   * @param ec Set to indicate what error occurred, if any.
+   */
+  void shutdown(wintls::error_code& ec) {
+    ec = sspi_datagram_->shutdown();
+    if (ec) {
+      return;
+    }
+    const auto size = next_layer_.send(sspi_datagram_->shutdown.buffer(), 0, ec);
+    if (!ec) {
+      sspi_datagram_->shutdown.size_written(size);
+    }
+  }
+
+  /** Send a DTLS close_notify alert to the peer.
+   *
+   * As datagrams may be lost, the peer can't rely on receiving it.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   */
+  void shutdown() {
+    wintls::error_code ec{};
+    shutdown(ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+  }
+
+  /** Asynchronously send a DTLS close_notify alert to the peer.
+   *
+   * As datagrams may be lost, the peer can't rely on receiving it.
+   *
+   * @param handler The handler to be called when the operation
+   * completes. The equivalent function signature of the handler must
+   * be:
+   * @code
+   * void handler(
+   *     wintls::error_code // Result of operation.
+   * );
+   * @endcode
+   */
+  template <class CompletionToken>
+  auto async_shutdown(CompletionToken&& handler) {
+    return net::async_compose<CompletionToken, void(wintls::error_code)>(
+        detail::async_datagram_shutdown<next_layer_type>{next_layer_, sspi_datagram_->shutdown}, handler);
+  }
+
+private:
+  NextLayer next_layer_;
+  std::unique_ptr<detail::sspi_datagram> sspi_datagram_;
+};
+
+} // namespace wintls
+
+#endif // WINTLS_DATAGRAM_STREAM_HPP
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_ASYNC_DATAGRAM_HANDSHAKE_HPP
+#define WINTLS_DETAIL_ASYNC_DATAGRAM_HANDSHAKE_HPP
+
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/coroutine.hpp>
+#include <wintls/detail/sspi_datagram.hpp>
+
+#include <memory>
+
+namespace wintls {
+namespace detail {
+
+// The number of times a handshake flight is retransmitted before
+// giving up, with the timeout doubling every time
+constexpr int max_handshake_retransmissions = 6;
+
+// DTLS handshake where each handshake message is sent as a datagram
+// and the last flight sent is retransmitted when no reply arrives
+// within the timeout
+template <typename NextLayer>
+struct async_datagram_handshake : net::coroutine {
+  enum class timer_state {
+    waiting,
+    expired,
+    finished
+  };
+
+  async_datagram_handshake(NextLayer& next_layer, sspi_datagram& datagram, handshake_type type)
+    : next_layer_(next_layer)
+    , datagram_(datagram)
+    , timeout_(datagram.retransmit_timeout)
+    , entry_count_(0) {
+    datagram_.handshake(type);
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec = {}, std::size_t length = 0) {
+    ++entry_count_;
+    auto is_continuation = [this] {
+      return entry_count_ > 1;
+    };
+
+    WINTLS_ASIO_CORO_REENTER(*this) {
+      for (;;) {
+        handshake_state_ = datagram_.handshake();
+        ec = error::make_error_code(datagram_.apply_mtu());
+        if (ec) {
+          if (!is_continuation()) {
+            WINTLS_ASIO_CORO_YIELD {
+              auto e = self.get_executor();
+              net::post(e, [self = std::move(self), ec]() mutable { self(ec); });
+            }
+          }
+          break;
+        }
+        if (handshake_state_ == sspi_handshake::state::done) {
+          break;
+        }
+
+        if (handshake_state_ == sspi_handshake::state::data_available ||
+            handshake_state_ == sspi_handshake::state::done_with_data ||
+            handshake_state_ == sspi_handshake::state::error_with_data) {
+          datagram_.handshake_sent(datagram_.handshake.out_buffer());
+          WINTLS_ASIO_CORO_YIELD {
+            next_layer_.async_send(datagram_.handshake.out_buffer(), std::move(self));
+          }
+          if (ec) {
+            break;
+          }
+          datagram_.handshake.size_written(length);
+          if (handshake_state_ == sspi_handshake::state::done_with_data) {
+            break;
+          }
+          if (handshake_state_ == sspi_handshake::state::error_with_data) {
+            ec = datagram_.handshake.last_error();
+            break;
+          }
+          continue;
+        }
+
+        if (handshake_state_ == sspi_handshake::state::data_needed) {
+          datagram_.handshake_flight_complete();
+          WINTLS_ASIO_CORO_YIELD {
+            start_timer();
+            next_layer_.async_receive(datagram_.handshake.in_buffer(), std::move(self));
+          }
+          // A reply received just as the timer expired is processed, so
+          // only a receive actually cancelled by the timer is a timeout
+          if (stop_timer() && ec == net::error::operation_aborted) {
+            if (++retransmissions_ > max_handshake_retransmissions) {
+              ec = net::error::timed_out;
+              break;
+            }
+            timeout_ *= 2;
+            for (flight_index_ = 0; flight_index_ < datagram_.flight().size(); ++flight_index_) {
+              WINTLS_ASIO_CORO_YIELD {
+                next_layer_.async_send(net::buffer(datagram_.flight()[flight_index_]), std::move(self));
+              }
+              if (ec) {
+                break;
+              }
+            }
+            if (ec) {
+              break;
+            }
+            continue;
+          }
+          if (ec) {
+            break;
+          }
+          retransmissions_ = 0;
+          timeout_ = datagram_.retransmit_timeout;
+          datagram_.handshake.size_read(length);
+          continue;
+        }
+
+        ec = datagram_.handshake.last_error();
+        if (!is_continuation()) {
+          WINTLS_ASIO_CORO_YIELD {
+            auto e = self.get_executor();
+            net::post(e, [self = std::move(self), ec, length]() mutable { self(ec, length); });
+          }
+        }
+        break;
+      }
+      self.complete(ec);
+    }
+  }
+
+private:
+  // Cancel the receive when no reply arrives in time
+  void start_timer() {
+    if (!timer_) {
+      timer_ = std::make_unique<net::steady_timer>(next_layer_.get_executor());
+    }
+    timer_state_ = std::make_shared<timer_state>(timer_state::waiting);
+    timer_->expires_after(timeout_);
+    timer_->async_wait([state = timer_state_, &next_layer = next_layer_](const wintls::error_code& ec) {
+      if (!ec && *state == timer_state::waiting) {
+        *state = timer_state::expired;
+        next_layer.cancel();
+      }
+    });
+  }
+
+  // Stop the timer after the receive completed, returning true if the
+  // timer expired and cancelled the receive, unless it had completed
+  // already
+  bool stop_timer() {
+    const bool expired = *timer_state_ == timer_state::expired;
+    *timer_state_ = timer_state::finished;
+    timer_->cancel();
+    return expired;
+  }
+
+  NextLayer& next_layer_;
+  sspi_datagram& datagram_;
+  sspi_handshake::state handshake_state_;
+  std::chrono::steady_clock::duration timeout_;
+  std::unique_ptr<net::steady_timer> timer_;
+  std::shared_ptr<timer_state> timer_state_;
+  int retransmissions_ = 0;
+  std::size_t flight_index_ = 0;
+  int entry_count_;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_ASYNC_DATAGRAM_HANDSHAKE_HPP
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_ASYNC_DATAGRAM_RECEIVE_HPP
+#define WINTLS_DETAIL_ASYNC_DATAGRAM_RECEIVE_HPP
+
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/coroutine.hpp>
+#include <wintls/detail/sspi_datagram.hpp>
+
+namespace wintls {
+namespace detail {
+
+// Receives datagrams until one holding application data arrives,
+// retransmitting the last handshake flight if the peer is still
+// waiting for it
+template <typename NextLayer, typename MutableBufferSequence>
+struct async_datagram_receive : net::coroutine {
+  async_datagram_receive(NextLayer& next_layer, const MutableBufferSequence& buffers, sspi_datagram& datagram)
+    : next_layer_(next_layer)
+    , buffers_(buffers)
+    , datagram_(datagram) {
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec = {}, std::size_t length = 0) {
+    WINTLS_ASIO_CORO_REENTER(*this) {
+      for (;;) {
+        WINTLS_ASIO_CORO_YIELD {
+          next_layer_.async_receive(datagram_.receive_buffer(), std::move(self));
+        }
+        if (ec) {
+          break;
+        }
+
+        state_ = datagram_.decrypt(length, buffers_, size_decrypted_, ec);
+        if (state_ != sspi_datagram::decrypt_state::discarded) {
+          break;
+        }
+
+        if (datagram_.received_handshake(length)) {
+          for (flight_index_ = 0; flight_index_ < datagram_.flight().size(); ++flight_index_) {
+            WINTLS_ASIO_CORO_YIELD {
+              next_layer_.async_send(net::buffer(datagram_.flight()[flight_index_]), std::move(self));
+            }
+            if (ec) {
+              break;
+            }
+          }
+          if (ec) {
+            break;
+          }
+        }
+      }
+      self.complete(ec, size_decrypted_);
+    }
+  }
+
+private:
+  NextLayer& next_layer_;
+  MutableBufferSequence buffers_;
+  sspi_datagram& datagram_;
+  sspi_datagram::decrypt_state state_ = sspi_datagram::decrypt_state::discarded;
+  std::size_t size_decrypted_ = 0;
+  std::size_t flight_index_ = 0;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_ASYNC_DATAGRAM_RECEIVE_HPP
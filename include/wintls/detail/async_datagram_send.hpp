@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_ASYNC_DATAGRAM_SEND_HPP
+#define WINTLS_DETAIL_ASYNC_DATAGRAM_SEND_HPP
+
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/coroutine.hpp>
+#include <wintls/detail/sspi_datagram.hpp>
+
+#include <vector>
+
+namespace wintls {
+namespace detail {
+
+// Sends the data encrypted as a single datagram. The data is copied
+// when the operation is created and encrypted when it is started, so
+// a deferred send doesn't use up a record sequence number. The record
+// is copied out of the encrypt buffers shared by the stream, so
+// several sends may be outstanding at a time.
+template <typename NextLayer>
+struct async_datagram_send : net::coroutine {
+  template <typename ConstBufferSequence>
+  async_datagram_send(NextLayer& next_layer, const ConstBufferSequence& buffers, sspi_datagram& datagram)
+    : next_layer_(next_layer)
+    , datagram_(datagram)
+    , data_(net::buffer_size(buffers)) {
+    net::buffer_copy(net::buffer(data_), buffers);
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec = {}, std::size_t = 0) {
+    WINTLS_ASIO_CORO_REENTER(*this) {
+      {
+        const auto record = datagram_.encrypt(net::buffer(data_), ec);
+        if (!ec) {
+          size_ = data_.size();
+          const auto first = static_cast<const char*>(record.data());
+          data_.assign(first, first + record.size());
+        }
+      }
+      if (ec) {
+        WINTLS_ASIO_CORO_YIELD {
+          auto e = self.get_executor();
+          net::post(e, [self = std::move(self), ec]() mutable { self(ec); });
+        }
+        self.complete(ec, 0);
+        return;
+      }
+      WINTLS_ASIO_CORO_YIELD {
+        next_layer_.async_send(net::buffer(data_), std::move(self));
+      }
+      self.complete(ec, ec ? 0 : size_);
+    }
+  }
+
+private:
+  NextLayer& next_layer_;
+  sspi_datagram& datagram_;
+  std::vector<char> data_;
+  std::size_t size_ = 0;
+};
+
+// Sends a close_notify alert as a datagram
+template <typename NextLayer>
+struct async_datagram_shutdown : net::coroutine {
+  async_datagram_shutdown(NextLayer& next_layer, sspi_shutdown& shutdown)
+    : next_layer_(next_layer)
+    , shutdown_(shutdown) {
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec = {}, std::size_t size_written = 0) {
+    WINTLS_ASIO_CORO_REENTER(*this) {
+      ec = shutdown_();
+      if (ec) {
+        WINTLS_ASIO_CORO_YIELD {
+          auto e = self.get_executor();
+          net::post(e, [self = std::move(self), ec]() mutable { self(ec); });
+        }
+        self.complete(ec);
+        return;
+      }
+      WINTLS_ASIO_CORO_YIELD {
+        next_layer_.async_send(shutdown_.buffer(), std::move(self));
+      }
+      if (!ec) {
+        shutdown_.size_written(size_written);
+      }
+      self.complete(ec);
+    }
+  }
+
+private:
+  NextLayer& next_layer_;
+  sspi_shutdown& shutdown_;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_ASYNC_DATAGRAM_SEND_HPP
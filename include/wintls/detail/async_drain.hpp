@@ -0,0 +1,234 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_ASYNC_DRAIN_HPP
+#define WINTLS_DETAIL_ASYNC_DRAIN_HPP
+
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/context_counters.hpp>
+#include <wintls/detail/stream_registry.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace wintls {
+namespace detail {
+
+// Shuts down the streams registered when the drain started, with at
+// most the given number of shutdowns in flight. At the deadline, the
+// next layers of the streams not shut down yet are closed instead.
+template <class Handler, class Executor>
+class drain_state : public std::enable_shared_from_this<drain_state<Handler, Executor>> {
+public:
+  drain_state(Handler&& handler,
+              const Executor& executor,
+              const stream_registry& registry,
+              context_counters& counters,
+              std::size_t concurrency)
+    : handler_(std::move(handler))
+    , work_(net::make_work_guard(executor))
+    , executor_(executor)
+    , timer_(executor)
+    , registry_(registry)
+    , counters_(counters)
+    , entries_(registry.entries())
+    , done_(entries_.size(), false)
+    , concurrency_(std::max(concurrency, std::size_t{1})) {
+  }
+
+  void start(std::chrono::steady_clock::time_point deadline) {
+    auto self = this->shared_from_this();
+    if (!registry_.enabled()) {
+      // Never complete inline from the initiating function
+      net::post(executor_, [self]() {
+        self->finish(net::error::operation_not_supported);
+      });
+      return;
+    }
+    counters_.drain_streams = entries_.size();
+    counters_.drain_shutdowns = 0;
+    counters_.drain_failures = 0;
+    counters_.drain_aborts = 0;
+    if (entries_.empty()) {
+      net::post(executor_, [self]() {
+        self->finish({});
+      });
+      return;
+    }
+
+    timer_.expires_at(deadline);
+    timer_.async_wait([self](const wintls::error_code& ec) {
+      if (!ec) {
+        self->deadline_reached();
+      }
+    });
+
+    std::vector<std::size_t> first;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      while (next_ < entries_.size() && first.size() < concurrency_) {
+        first.push_back(next_++);
+      }
+    }
+    for (auto index : first) {
+      shut_down(index);
+    }
+  }
+
+private:
+  // Run the function on the executor of the stream, or on the executor
+  // of the drain with null if the stream has been destroyed, so it is
+  // never run inline
+  void post(std::size_t index, std::function<void(registry_entry*)> function) {
+    if (!registry_.post(entries_[index], function)) {
+      net::post(executor_, [function = std::move(function)]() {
+        function(nullptr);
+      });
+    }
+  }
+
+  void shut_down(std::size_t index) {
+    auto self = this->shared_from_this();
+    post(index, [self, index](registry_entry* entry) {
+      if (entry == nullptr) {
+        // Destroyed by the application in the meantime
+        self->shutdown_done(index, {});
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        if (self->done_[index]) {
+          return;
+        }
+      }
+      entry->shutdown(entry->owner, [self, index](const wintls::error_code& ec) {
+        self->shutdown_done(index, ec);
+      });
+    });
+  }
+
+  void shutdown_done(std::size_t index, const wintls::error_code& ec) {
+    std::size_t next = entries_.size();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (done_[index]) {
+        // Closed at the deadline
+        return;
+      }
+      done_[index] = true;
+      ++completed_;
+      if (ec) {
+        ++counters_.drain_failures;
+      } else {
+        ++counters_.drain_shutdowns;
+      }
+      if (!deadline_reached_ && next_ < entries_.size()) {
+        next = next_++;
+      }
+    }
+    if (next != entries_.size()) {
+      shut_down(next);
+    }
+    maybe_finish();
+  }
+
+  void deadline_reached() {
+    std::vector<std::size_t> remaining;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      deadline_reached_ = true;
+      for (std::size_t i = 0; i < entries_.size(); ++i) {
+        if (!done_[i]) {
+          done_[i] = true;
+          remaining.push_back(i);
+        }
+      }
+    }
+    auto self = this->shared_from_this();
+    for (auto index : remaining) {
+      post(index, [self](registry_entry* entry) {
+        if (entry != nullptr) {
+          entry->close(entry->owner);
+        }
+        {
+          std::lock_guard<std::mutex> lock(self->mutex_);
+          ++self->completed_;
+          ++self->counters_.drain_aborts;
+        }
+        self->maybe_finish();
+      });
+    }
+  }
+
+  void maybe_finish() {
+    wintls::error_code ec{};
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (completed_ != entries_.size() || finished_) {
+        return;
+      }
+      finished_ = true;
+      if (deadline_reached_) {
+        ec = net::error::timed_out;
+      }
+    }
+    // The timer is only used from the executor of the drain
+    auto self = this->shared_from_this();
+    net::post(executor_, [self, ec]() {
+      self->timer_.cancel();
+      self->finish(ec);
+    });
+  }
+
+  void finish(const wintls::error_code& ec) {
+    auto ex = net::get_associated_executor(handler_, executor_);
+    net::dispatch(ex, [handler = std::move(handler_), ec]() mutable {
+      handler(ec);
+    });
+    work_.reset();
+  }
+
+  Handler handler_;
+  net::executor_work_guard<Executor> work_;
+  Executor executor_;
+  net::steady_timer timer_;
+  const stream_registry& registry_;
+  context_counters& counters_;
+  std::vector<std::shared_ptr<registry_entry>> entries_;
+  std::mutex mutex_;
+  std::vector<bool> done_;
+  std::size_t concurrency_;
+  std::size_t next_ = 0;
+  std::size_t completed_ = 0;
+  bool deadline_reached_ = false;
+  bool finished_ = false;
+};
+
+// Starts draining the streams registered in a context
+struct drain_initiation {
+  template <class Handler, class Executor>
+  void operator()(Handler&& handler,
+                  const Executor& executor,
+                  const stream_registry* registry,
+                  context_counters* counters,
+                  std::chrono::steady_clock::time_point deadline,
+                  std::size_t concurrency) const {
+    auto state = std::make_shared<drain_state<typename std::decay<Handler>::type, Executor>>(
+      std::move(handler), executor, *registry, *counters, concurrency);
+    state->start(deadline);
+  }
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_ASYNC_DRAIN_HPP
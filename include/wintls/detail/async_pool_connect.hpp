@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_ASYNC_POOL_CONNECT_HPP
+#define WINTLS_DETAIL_ASYNC_POOL_CONNECT_HPP
+
+#include <wintls/detail/config.hpp>
+
+#include <wintls/handshake_type.hpp>
+
+#include <memory>
+#include <string>
+
+namespace wintls {
+namespace detail {
+
+// Completes with an idle stream taken from the pool, or else resolves
+// the host, connects and performs the client handshake on a new one.
+template <typename Stream>
+struct async_pool_connect {
+  using protocol_type = typename Stream::next_layer_type::protocol_type;
+  using resolver_type = typename protocol_type::resolver;
+
+  template <typename Executor>
+  async_pool_connect(const Executor& executor,
+                     std::unique_ptr<Stream> idle_stream,
+                     context& ctx,
+                     const std::string& host,
+                     const std::string& port,
+                     const std::string& server_hostname)
+    : stream_(std::move(idle_stream))
+    , host_(host)
+    , port_(port) {
+    if (!stream_) {
+      stream_ = std::make_unique<Stream>(executor, ctx);
+      stream_->set_server_hostname(server_hostname);
+      resolver_ = std::make_unique<resolver_type>(executor);
+    }
+  }
+
+  template <typename Self>
+  void operator()(Self& self) {
+    if (!resolver_) {
+      // Reusing an idle stream
+      auto e = self.get_executor();
+      net::post(e, [self = std::move(self)]() mutable { self(wintls::error_code{}); });
+      return;
+    }
+    auto& resolver = *resolver_;
+    resolver.async_resolve(host_, port_, std::move(self));
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec, typename resolver_type::results_type results) {
+    if (ec) {
+      return complete(self, ec);
+    }
+    net::async_connect(stream_->next_layer(), results, std::move(self));
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec, const typename protocol_type::endpoint&) {
+    if (ec) {
+      return complete(self, ec);
+    }
+    auto& stream = *stream_;
+    resolver_.reset();
+    stream.async_handshake(handshake_type::client, std::move(self));
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec) {
+    complete(self, ec);
+  }
+
+private:
+  template <typename Self>
+  void complete(Self& self, wintls::error_code ec) {
+    if (ec) {
+      stream_.reset();
+    }
+    self.complete(ec, std::move(stream_));
+  }
+
+  std::unique_ptr<Stream> stream_;
+  std::unique_ptr<resolver_type> resolver_;
+  std::string host_;
+  std::string port_;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_ASYNC_POOL_CONNECT_HPP
@@ -10,6 +10,7 @@
 
 #include <wintls/detail/config.hpp>
 #include <wintls/detail/coroutine.hpp>
+#include <wintls/detail/read_ahead.hpp>
 #include <wintls/detail/sspi_decrypt.hpp>
 
 namespace wintls {
@@ -17,15 +18,24 @@ namespace detail {
 
 template <typename NextLayer, typename MutableBufferSequence>
 struct async_read : net::coroutine {
-  async_read(NextLayer& next_layer, const MutableBufferSequence& buffers, detail::sspi_decrypt& decrypt)
+  async_read(NextLayer& next_layer,
+             const MutableBufferSequence& buffers,
+             detail::sspi_decrypt& decrypt,
+             detail::read_ahead* read_ahead = nullptr)
     : next_layer_(next_layer)
     , buffers_(buffers)
     , decrypt_(decrypt)
+    , read_ahead_(read_ahead)
     , entry_count_(0) {
   }
 
   template <typename Self>
   void operator()(Self& self, wintls::error_code ec = {}, std::size_t size_read = 0) {
+    if (waiting_for_read_ahead_) {
+      // The wait always completes with operation_aborted
+      waiting_for_read_ahead_ = false;
+      ec = {};
+    }
     if (ec) {
       self.complete(ec, size_read);
       return;
@@ -39,6 +49,21 @@ struct async_read : net::coroutine {
     detail::sspi_decrypt::state state;
     WINTLS_ASIO_CORO_REENTER(*this) {
       while((state = decrypt_(buffers_)) == detail::sspi_decrypt::state::data_needed) {
+        if (read_ahead_ != nullptr && read_ahead_->in_progress()) {
+          WINTLS_ASIO_CORO_YIELD {
+            waiting_for_read_ahead_ = true;
+            read_ahead_->async_wait(std::move(self));
+          }
+        }
+        if (read_ahead_ != nullptr && read_ahead_->completed()) {
+          size_read = read_ahead_->take(decrypt_.input_buffer, ec);
+          if (ec) {
+            self.complete(ec, 0);
+            return;
+          }
+          decrypt_.size_read(size_read);
+          continue;
+        }
         WINTLS_ASIO_CORO_YIELD {
           next_layer_.async_read_some(decrypt_.input_buffer, std::move(self));
         }
@@ -58,6 +83,9 @@ struct async_read : net::coroutine {
         return;
       }
 
+      if (read_ahead_ != nullptr) {
+        read_ahead_->start(next_layer_, self.get_executor());
+      }
       self.complete(wintls::error_code{}, decrypt_.size_decrypted);
     }
   }
@@ -66,6 +94,8 @@ private:
   NextLayer& next_layer_;
   MutableBufferSequence buffers_;
   detail::sspi_decrypt& decrypt_;
+  detail::read_ahead* read_ahead_;
+  bool waiting_for_read_ahead_ = false;
   int entry_count_;
 };
 
@@ -0,0 +1,193 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_ASYNC_RELAY_HPP
+#define WINTLS_DETAIL_ASYNC_RELAY_HPP
+
+#include <wintls/stream.hpp>
+
+#include <wintls/detail/async_read.hpp>
+#include <wintls/detail/async_shutdown.hpp>
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/coroutine.hpp>
+#include <wintls/detail/sspi_stream.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace wintls {
+namespace detail {
+
+// True if the error means the peer has finished sending
+inline bool is_end_of_stream(const wintls::error_code& ec) {
+  return ec == net::error::eof ||
+         (ec.category() == wintls::system_category() && ec.value() == SEC_I_CONTEXT_EXPIRED);
+}
+
+// Relays data in one direction, decrypting each record directly into
+// the record data region of the destination and encrypting it in
+// place there. Only one record is in flight, so reading from the
+// source pauses while the destination is slow.
+template <class SourceNextLayer, class DestinationNextLayer>
+struct async_relay_direction : net::coroutine {
+  async_relay_direction(SourceNextLayer& source, sspi_stream& source_sspi,
+                        DestinationNextLayer& destination, sspi_stream& destination_sspi)
+    : source_(source)
+    , source_sspi_(source_sspi)
+    , destination_(destination)
+    , destination_sspi_(destination_sspi) {
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec = {}, std::size_t size = 0) {
+    WINTLS_ASIO_CORO_REENTER(*this) {
+      for (;;) {
+        {
+          SECURITY_STATUS sc = SEC_E_OK;
+          region_ = destination_sspi_.encrypt.buffers.data_region(sc);
+          if (sc != SEC_E_OK) {
+            ec = error::make_error_code(sc);
+            break;
+          }
+          // Wait until a record can be sent within the rate limit of
+          // the destination, if any, before reading what to send
+          const auto delay = destination_sspi_.encrypt.write_delay(region_.size(), ec);
+          if (ec) {
+            break;
+          }
+          waiting_ = delay != delay.zero();
+          if (waiting_) {
+            if (!timer_) {
+              timer_ = std::make_unique<net::steady_timer>(destination_.get_executor());
+            }
+            timer_->expires_after(delay);
+          }
+        }
+        if (waiting_) {
+          WINTLS_ASIO_CORO_YIELD {
+            timer_->async_wait(std::move(self));
+          }
+          if (ec) {
+            break;
+          }
+        }
+        region_ = net::buffer(region_, destination_sspi_.encrypt.rate_limited_size(region_.size()));
+        WINTLS_ASIO_CORO_YIELD {
+          net::async_compose<Self, void(wintls::error_code, std::size_t)>(
+            async_read<SourceNextLayer, net::mutable_buffer>{
+              source_, region_, source_sspi_.decrypt, source_sspi_.read_ahead.get()}, self);
+        }
+        if (ec) {
+          break;
+        }
+
+        destination_sspi_.encrypt.encrypt_in_place(size, ec);
+        if (ec) {
+          break;
+        }
+        WINTLS_ASIO_CORO_YIELD {
+          net::async_write(destination_, destination_sspi_.encrypt.output(), std::move(self));
+        }
+        destination_sspi_.encrypt.size_written();
+        if (ec) {
+          break;
+        }
+      }
+
+      if (!is_end_of_stream(ec)) {
+        self.complete(ec);
+        return;
+      }
+
+      // Forward the end of the stream as a TLS shutdown
+      WINTLS_ASIO_CORO_YIELD {
+        net::async_compose<Self, void(wintls::error_code)>(
+          async_shutdown<DestinationNextLayer>{destination_, destination_sspi_.shutdown}, self);
+      }
+      self.complete(ec);
+    }
+  }
+
+private:
+  SourceNextLayer& source_;
+  sspi_stream& source_sspi_;
+  DestinationNextLayer& destination_;
+  sspi_stream& destination_sspi_;
+  net::mutable_buffer region_;
+  bool waiting_ = false;
+  std::unique_ptr<net::steady_timer> timer_;
+};
+
+// Completes the handler when both directions are done, with the
+// first error
+template <class Handler, class Executor>
+class relay_state {
+public:
+  relay_state(Handler&& handler, const Executor& executor)
+    : handler_(std::move(handler))
+    , work_(net::make_work_guard(executor))
+    , executor_(executor) {
+  }
+
+  void direction_done(const wintls::error_code& ec) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (ec && !ec_) {
+        ec_ = ec;
+      }
+    }
+    if (--remaining_ != 0) {
+      return;
+    }
+    auto ex = net::get_associated_executor(handler_, executor_);
+    net::dispatch(ex, [handler = std::move(handler_), ec = ec_]() mutable {
+      handler(ec);
+    });
+    work_.reset();
+  }
+
+private:
+  Handler handler_;
+  net::executor_work_guard<Executor> work_;
+  Executor executor_;
+  std::mutex mutex_;
+  wintls::error_code ec_;
+  std::atomic<int> remaining_{2};
+};
+
+// Starts both directions of a relay between two streams. Each
+// direction encrypts on one security context and decrypts on the
+// other, and forwarding the end of the stream shuts down the context
+// the other direction is reading from, so both directions run on the
+// same strand to never use a security context concurrently.
+struct relay_initiation {
+  template <class Handler, class NextLayerA, class NextLayerB>
+  void operator()(Handler&& handler, stream<NextLayerA>* a, stream<NextLayerB>* b) const {
+    using executor_type = typename stream<NextLayerA>::executor_type;
+    auto state = std::make_shared<relay_state<typename std::decay<Handler>::type, executor_type>>(
+      std::move(handler), a->get_executor());
+    auto a_to_b_done = net::bind_executor(net::make_strand(a->get_executor()), [state](const wintls::error_code& ec) {
+      state->direction_done(ec);
+    });
+    auto b_to_a_done = a_to_b_done;
+
+    using a_to_b = async_relay_direction<typename stream<NextLayerA>::next_layer_type,
+                                         typename stream<NextLayerB>::next_layer_type>;
+    using b_to_a = async_relay_direction<typename stream<NextLayerB>::next_layer_type,
+                                         typename stream<NextLayerA>::next_layer_type>;
+    net::async_compose<decltype(a_to_b_done), void(wintls::error_code)>(
+      a_to_b{a->next_layer_, *a->sspi_stream_, b->next_layer_, *b->sspi_stream_}, a_to_b_done, a->next_layer_);
+    net::async_compose<decltype(b_to_a_done), void(wintls::error_code)>(
+      b_to_a{b->next_layer_, *b->sspi_stream_, a->next_layer_, *a->sspi_stream_}, b_to_a_done, b->next_layer_);
+  }
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_ASYNC_RELAY_HPP
@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_ASYNC_SEND_FILE_HPP
+#define WINTLS_DETAIL_ASYNC_SEND_FILE_HPP
+
+#include <wintls/stream.hpp>
+
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/coroutine.hpp>
+#include <wintls/detail/sspi_stream.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+namespace wintls {
+namespace detail {
+
+// Reads the file directly into the record data region of the stream
+// and encrypts it in place there, one record at a time
+template <class NextLayer, class File>
+struct async_send_file : net::coroutine {
+  async_send_file(NextLayer& next_layer, sspi_stream& sspi, File& file, std::uint64_t offset, std::uint64_t size)
+    : next_layer_(next_layer)
+    , sspi_(sspi)
+    , file_(file)
+    , offset_(offset)
+    , remaining_(size) {
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec = {}, std::size_t size = 0) {
+    WINTLS_ASIO_CORO_REENTER(*this) {
+      while (remaining_ != 0) {
+        {
+          // Wait until a record can be sent within the rate limit, if any
+          const auto delay = sspi_.encrypt.write_delay(remaining_size(), ec);
+          if (ec) {
+            break;
+          }
+          waiting_ = delay != delay.zero();
+          if (waiting_) {
+            if (!timer_) {
+              timer_ = std::make_unique<net::steady_timer>(next_layer_.get_executor());
+            }
+            timer_->expires_after(delay);
+          }
+        }
+        if (waiting_) {
+          WINTLS_ASIO_CORO_YIELD {
+            timer_->async_wait(std::move(self));
+          }
+          if (ec) {
+            break;
+          }
+        }
+        {
+          SECURITY_STATUS sc = SEC_E_OK;
+          auto region = sspi_.encrypt.buffers.data_region(sc);
+          if (sc != SEC_E_OK) {
+            ec = error::make_error_code(sc);
+            break;
+          }
+          region_ = net::buffer(region, sspi_.encrypt.rate_limited_size(std::min(region.size(), remaining_size())));
+        }
+        WINTLS_ASIO_CORO_YIELD {
+          file_.async_read_some_at(offset_, region_, std::move(self));
+        }
+        if (ec == net::error::eof && size == 0) {
+          // The file is shorter than the requested size
+          ec = {};
+          break;
+        }
+        if (ec) {
+          break;
+        }
+        offset_ += size;
+        remaining_ -= size;
+        size_read_ = size;
+
+        sspi_.encrypt.encrypt_in_place(size, ec);
+        if (ec) {
+          break;
+        }
+        WINTLS_ASIO_CORO_YIELD {
+          net::async_write(next_layer_, sspi_.encrypt.output(), std::move(self));
+        }
+        sspi_.encrypt.size_written();
+        if (ec) {
+          break;
+        }
+        bytes_sent_ += size_read_;
+      }
+      self.complete(ec, bytes_sent_);
+    }
+  }
+
+private:
+  std::size_t remaining_size() const {
+    return static_cast<std::size_t>(std::min<std::uint64_t>(remaining_, std::numeric_limits<std::size_t>::max()));
+  }
+
+  NextLayer& next_layer_;
+  sspi_stream& sspi_;
+  File& file_;
+  std::uint64_t offset_;
+  std::uint64_t remaining_;
+  net::mutable_buffer region_;
+  std::size_t size_read_ = 0;
+  std::uint64_t bytes_sent_ = 0;
+  bool waiting_ = false;
+  std::unique_ptr<net::steady_timer> timer_;
+};
+
+struct send_file_initiation {
+  template <class Handler, class NextLayer, class File>
+  void operator()(Handler&& handler, stream<NextLayer>* s, File* file, std::uint64_t offset, std::uint64_t size) const {
+    using op_type = async_send_file<typename stream<NextLayer>::next_layer_type, File>;
+    net::async_compose<Handler, void(wintls::error_code, std::uint64_t)>(
+      op_type{s->next_layer_, *s->sspi_stream_, *file, offset, size}, handler, s->next_layer_);
+  }
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_ASYNC_SEND_FILE_HPP
@@ -35,9 +35,8 @@ struct async_shutdown : net::coroutine {
       return entry_count_ > 1;
     };
 
-    ec = shutdown_();
-
     WINTLS_ASIO_CORO_REENTER(*this) {
+      ec = shutdown_();
       if (!ec) {
         WINTLS_ASIO_CORO_YIELD {
           net::async_write(next_layer_, shutdown_.buffer(), std::move(self));
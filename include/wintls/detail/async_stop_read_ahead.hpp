@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_ASYNC_STOP_READ_AHEAD_HPP
+#define WINTLS_DETAIL_ASYNC_STOP_READ_AHEAD_HPP
+
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/coroutine.hpp>
+#include <wintls/detail/read_ahead.hpp>
+
+namespace wintls {
+namespace detail {
+
+// Disables read ahead and waits for an outstanding read ahead, if
+// any, keeping the data it reads
+struct async_stop_read_ahead : net::coroutine {
+  explicit async_stop_read_ahead(detail::read_ahead* read_ahead)
+    : read_ahead_(read_ahead) {
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec = {}) {
+    // The wait always completes with operation_aborted
+    (void)(ec);
+    WINTLS_ASIO_CORO_REENTER(*this) {
+      if (read_ahead_ != nullptr) {
+        read_ahead_->set_max_size(0);
+      }
+      if (read_ahead_ != nullptr && read_ahead_->in_progress()) {
+        WINTLS_ASIO_CORO_YIELD {
+          read_ahead_->async_wait(std::move(self));
+        }
+      } else {
+        WINTLS_ASIO_CORO_YIELD {
+          auto e = self.get_executor();
+          net::post(e, [self = std::move(self)]() mutable { self(wintls::error_code{}); });
+        }
+      }
+      self.complete(wintls::error_code{});
+    }
+  }
+
+private:
+  detail::read_ahead* read_ahead_;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_ASYNC_STOP_READ_AHEAD_HPP
@@ -12,6 +12,8 @@
 #include <wintls/detail/coroutine.hpp>
 #include <wintls/detail/sspi_encrypt.hpp>
 
+#include <memory>
+
 namespace wintls {
 namespace detail {
 
@@ -27,6 +29,26 @@ struct async_write : net::coroutine {
   void operator()(Self& self, wintls::error_code ec = {}, std::size_t length = 0) {
     (void)(length);
     WINTLS_ASIO_CORO_REENTER(*this) {
+      {
+        const auto delay = encrypt_.write_delay(net::buffer_size(buffer_), ec);
+        if (ec) {
+          self.complete(ec, 0);
+          return;
+        }
+        if (delay != delay.zero()) {
+          timer_ = std::make_unique<net::steady_timer>(next_layer_.get_executor(), delay);
+        }
+      }
+      if (timer_) {
+        WINTLS_ASIO_CORO_YIELD {
+          timer_->async_wait(std::move(self));
+        }
+        if (ec) {
+          self.complete(ec, 0);
+          return;
+        }
+      }
+
       bytes_consumed_ = encrypt_(buffer_, ec);
       if (ec) {
         self.complete(ec, 0);
@@ -34,8 +56,9 @@ struct async_write : net::coroutine {
       }
 
       WINTLS_ASIO_CORO_YIELD {
-        net::async_write(next_layer_, encrypt_.buffers, std::move(self));
+        net::async_write(next_layer_, encrypt_.output(), std::move(self));
       }
+      encrypt_.size_written();
       self.complete(ec, bytes_consumed_);
     }
   }
@@ -45,6 +68,7 @@ private:
   ConstBufferSequence buffer_;
   detail::sspi_encrypt& encrypt_;
   size_t bytes_consumed_{0};
+  std::unique_ptr<net::steady_timer> timer_;
 };
 
 } // detail
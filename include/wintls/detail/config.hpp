@@ -30,6 +30,16 @@
 #pragma comment(lib, "secur32")
 #endif // !__MINGW32__
 
+// Compile the non-template parts of the library once in a separate
+// translation unit, see wintls/impl/src.hpp
+#ifdef WINTLS_SEPARATE_COMPILATION
+#define WINTLS_HEADER_ONLY 0
+#define WINTLS_DECL
+#else // WINTLS_SEPARATE_COMPILATION
+#define WINTLS_HEADER_ONLY 1
+#define WINTLS_DECL inline
+#endif // !WINTLS_SEPARATE_COMPILATION
+
 #ifdef _MSC_VER
 #define WINTLS_UNREACHABLE_RETURN(x) __assume(0);
 #else // _MSC_VER
@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_CONTEXT_COUNTERS_HPP
+#define WINTLS_DETAIL_CONTEXT_COUNTERS_HPP
+
+#include <wintls/context_statistics.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+namespace wintls {
+namespace detail {
+
+// Counters shared by all streams using a context, which may run on
+// different threads
+struct context_counters {
+  context_statistics snapshot() const {
+    return context_statistics{shutdowns.load(),
+                              aborts.load(),
+                              streams.load(),
+                              drain_streams.load(),
+                              drain_shutdowns.load(),
+                              drain_failures.load(),
+                              drain_aborts.load(),
+                              credentials_acquired.load()};
+  }
+
+  std::atomic<std::uint64_t> shutdowns{0};
+  std::atomic<std::uint64_t> aborts{0};
+  std::atomic<std::uint64_t> streams{0};
+  std::atomic<std::uint64_t> drain_streams{0};
+  std::atomic<std::uint64_t> drain_shutdowns{0};
+  std::atomic<std::uint64_t> drain_failures{0};
+  std::atomic<std::uint64_t> drain_aborts{0};
+  std::atomic<std::uint64_t> credentials_acquired{0};
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_CONTEXT_COUNTERS_HPP
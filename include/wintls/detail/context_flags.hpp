@@ -29,6 +29,10 @@ constexpr DWORD server_context_flags =
   ASC_REQ_ALLOCATE_MEMORY | // Allocate buffers. Free them with FreeContextBuffer
   ASC_REQ_STREAM; // Support a stream-oriented connection
 
+// The same flags for DTLS, which is datagram-oriented
+constexpr DWORD client_datagram_context_flags = (client_context_flags & ~ISC_REQ_STREAM) | ISC_REQ_DATAGRAM;
+constexpr DWORD server_datagram_context_flags = (server_context_flags & ~ASC_REQ_STREAM) | ASC_REQ_DATAGRAM;
+
 } // namespace detail
 } // namespace wintls
 
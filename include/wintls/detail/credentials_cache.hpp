@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_CREDENTIALS_CACHE_HPP
+#define WINTLS_DETAIL_CREDENTIALS_CACHE_HPP
+
+#include <wintls/detail/sspi_sec_handle.hpp>
+
+#include <array>
+#include <memory>
+#include <mutex>
+
+namespace wintls {
+namespace detail {
+
+// Credentials handles shared between all streams using the same
+// context. Schannel caches TLS sessions per credentials handle, so
+// sharing them is what makes reconnections resume previous sessions.
+class credentials_cache {
+public:
+  // Get the shared credentials for the given usage and revocation
+  // checking, using the given function for acquiring them if not
+  // already cached.
+  template <typename Acquire>
+  std::shared_ptr<cred_handle> get(unsigned long usage, bool check_revocation, SECURITY_STATUS& status, Acquire&& acquire) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = entries_[(usage == SECPKG_CRED_INBOUND ? 2 : 0) + (check_revocation ? 1 : 0)];
+    status = SEC_E_OK;
+    if (!entry) {
+      auto handle = std::make_shared<cred_handle>();
+      status = acquire(*handle);
+      if (status != SEC_E_OK) {
+        return nullptr;
+      }
+      entry = std::move(handle);
+    }
+    return entry;
+  }
+
+  // Streams already using the cached credentials keep them alive
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+      entry.reset();
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::array<std::shared_ptr<cred_handle>, 4> entries_;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_CREDENTIALS_CACHE_HPP
@@ -15,6 +15,10 @@
 namespace wintls {
 namespace detail {
 
+// The maximum number of records encrypted for a single write to the
+// next layer
+constexpr std::size_t max_records_per_write = 4;
+
 class encrypt_buffers : public sspi_buffer_sequence<4> {
 public:
   encrypt_buffers(ctxt_handle& ctxt_handle)
@@ -27,31 +31,63 @@ public:
     , ctxt_handle_(ctxt_handle) {
   }
 
-  template <typename ConstBufferSequence> std::size_t operator()(const ConstBufferSequence& buffers, SECURITY_STATUS& sc) {
+  // The region of the record data of the given record, for filling in
+  // the plaintext directly before calling prepare
+  net::mutable_buffer data_region(SECURITY_STATUS& sc, std::size_t record = 0) {
     if (data_.empty()) {
       sc = sspi_functions::QueryContextAttributes(ctxt_handle_.get(), SECPKG_ATTR_STREAM_SIZES, &stream_sizes_);
       if (sc != SEC_E_OK) {
-        return 0;
+        return {};
       }
-      data_.resize(stream_sizes_.cbHeader + stream_sizes_.cbMaximumMessage + stream_sizes_.cbTrailer);
+      data_.resize(record_size());
+    }
+    return net::buffer(data_.data() + record * record_size() + stream_sizes_.cbHeader, stream_sizes_.cbMaximumMessage);
+  }
+
+  // Make room for the given number of records. Must be called before
+  // preparing any of them, as it may move the data.
+  void reserve_records(std::size_t records) {
+    if (data_.size() < records * record_size()) {
+      data_.resize(records * record_size());
     }
+  }
+
+  // The maximum size of the data in a single record
+  std::size_t max_message_size() const {
+    return stream_sizes_.cbMaximumMessage;
+  }
+
+  // The size of the record header and trailer
+  std::size_t overhead() const {
+    return stream_sizes_.cbHeader + stream_sizes_.cbTrailer;
+  }
 
-    const auto size_consumed = std::min(net::buffer_size(buffers), static_cast<size_t>(stream_sizes_.cbMaximumMessage));
+  // Set up the buffers for a record with the given amount of data
+  // already in its data region
+  void prepare(std::size_t size, std::size_t record = 0) {
+    const auto begin = data_.data() + record * record_size();
 
-    buffers_[0].pvBuffer = data_.data();
+    buffers_[0].pvBuffer = begin;
     buffers_[0].cbBuffer = stream_sizes_.cbHeader;
 
-    net::buffer_copy(net::buffer(data_.data() + stream_sizes_.cbHeader, size_consumed), buffers);
-    buffers_[1].pvBuffer = data_.data() + stream_sizes_.cbHeader;
-    buffers_[1].cbBuffer = static_cast<ULONG>(size_consumed);
+    buffers_[1].pvBuffer = begin + stream_sizes_.cbHeader;
+    buffers_[1].cbBuffer = static_cast<ULONG>(size);
 
-    buffers_[2].pvBuffer = data_.data() + stream_sizes_.cbHeader + size_consumed;
+    buffers_[2].pvBuffer = begin + stream_sizes_.cbHeader + size;
     buffers_[2].cbBuffer = stream_sizes_.cbTrailer;
+  }
 
-    return size_consumed;
+  // The most recently prepared record after being encrypted. The
+  // trailer may be shorter than reserved for.
+  net::const_buffer record() const {
+    return net::buffer(buffers_[0].pvBuffer, buffers_[0].cbBuffer + buffers_[1].cbBuffer + buffers_[2].cbBuffer);
   }
 
 private:
+  std::size_t record_size() const {
+    return stream_sizes_.cbHeader + stream_sizes_.cbMaximumMessage + stream_sizes_.cbTrailer;
+  }
+
   ctxt_handle& ctxt_handle_;
   std::vector<char> data_;
   SecPkgContext_StreamSizes stream_sizes_{0, 0, 0, 0, 0};
@@ -0,0 +1,39 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_HANDLE_COUNTER_HPP
+#define WINTLS_DETAIL_HANDLE_COUNTER_HPP
+
+#include <atomic>
+
+namespace wintls {
+namespace detail {
+
+// Number of live SSPI resources of the given type, counted where they
+// are acquired and freed. Only updated when
+// WINTLS_ENABLE_HANDLE_COUNTERS is defined, which is meant for leak
+// hunting in long running tests.
+template <typename Handle>
+struct handle_counter {
+  static std::atomic<long>& live() {
+    static std::atomic<long> count{0};
+    return count;
+  }
+};
+
+} // namespace detail
+} // namespace wintls
+
+#ifdef WINTLS_ENABLE_HANDLE_COUNTERS
+#define WINTLS_HANDLE_COUNTER_INCREMENT(type) (++::wintls::detail::handle_counter<type>::live())
+#define WINTLS_HANDLE_COUNTER_DECREMENT(type) (--::wintls::detail::handle_counter<type>::live())
+#else // WINTLS_ENABLE_HANDLE_COUNTERS
+#define WINTLS_HANDLE_COUNTER_INCREMENT(type) ((void)0)
+#define WINTLS_HANDLE_COUNTER_DECREMENT(type) ((void)0)
+#endif // !WINTLS_ENABLE_HANDLE_COUNTERS
+
+#endif // WINTLS_DETAIL_HANDLE_COUNTER_HPP
@@ -0,0 +1,215 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_HAPPY_EYEBALLS_HPP
+#define WINTLS_DETAIL_HAPPY_EYEBALLS_HPP
+
+#include <wintls/detail/config.hpp>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace wintls {
+namespace detail {
+
+// Order the endpoints alternating between address families, starting
+// with the family of the first endpoint, as described in RFC 8305
+// section 4. The order within each family is kept.
+template <class Endpoint>
+std::vector<Endpoint> interleave_address_families(const std::vector<Endpoint>& endpoints) {
+  if (endpoints.empty()) {
+    return endpoints;
+  }
+  const bool first_is_v6 = endpoints.front().address().is_v6();
+  std::vector<Endpoint> first;
+  std::vector<Endpoint> second;
+  for (const auto& endpoint : endpoints) {
+    (endpoint.address().is_v6() == first_is_v6 ? first : second).push_back(endpoint);
+  }
+  std::vector<Endpoint> ret;
+  ret.reserve(endpoints.size());
+  for (std::size_t i = 0; i < first.size() || i < second.size(); ++i) {
+    if (i < first.size()) {
+      ret.push_back(first[i]);
+    }
+    if (i < second.size()) {
+      ret.push_back(second[i]);
+    }
+  }
+  return ret;
+}
+
+// Races staggered connection attempts to the endpoints in order,
+// starting the next attempt when the previous one fails or hasn't
+// completed within the attempt delay. Completes with the first
+// connected socket, closing all others.
+//
+// All internal handlers run on a strand as several connection
+// attempts are outstanding at the same time.
+template <class Socket, class Handler>
+class happy_eyeballs_race : public std::enable_shared_from_this<happy_eyeballs_race<Socket, Handler>> {
+public:
+  using endpoint_type = typename Socket::endpoint_type;
+  using executor_type = typename Socket::executor_type;
+
+  happy_eyeballs_race(const executor_type& executor,
+                      std::vector<endpoint_type> endpoints,
+                      std::chrono::steady_clock::duration attempt_delay,
+                      Handler&& handler)
+    : executor_(executor)
+    , strand_(net::make_strand(executor))
+    , endpoints_(std::move(endpoints))
+    , attempt_delay_(attempt_delay)
+    , timer_(strand_)
+    , work_(net::make_work_guard(executor))
+    , handler_(std::move(handler)) {
+    sockets_.resize(endpoints_.size());
+  }
+
+  void start() {
+    net::dispatch(strand_, [self = this->shared_from_this()]() {
+      self->start_next();
+    });
+  }
+
+private:
+  void start_next() {
+    const auto index = next_++;
+    sockets_[index] = std::make_unique<Socket>(executor_);
+    ++pending_;
+    sockets_[index]->async_connect(endpoints_[index],
+                                   net::bind_executor(strand_, [self = this->shared_from_this(), index](const wintls::error_code& ec) {
+      self->on_connect(index, ec);
+    }));
+
+    if (next_ < endpoints_.size()) {
+      // The wait may already have completed with its handler queued
+      // when the attempt fails and starts the next one, so handlers of
+      // earlier waits are ignored
+      const auto generation = ++wait_generation_;
+      timer_.expires_after(attempt_delay_);
+      timer_.async_wait([self = this->shared_from_this(), generation](const wintls::error_code& ec) {
+        if (!ec && !self->done_ && generation == self->wait_generation_ && self->next_ < self->endpoints_.size()) {
+          self->start_next();
+        }
+      });
+    }
+  }
+
+  void on_connect(std::size_t index, const wintls::error_code& ec) {
+    --pending_;
+    if (done_) {
+      // Lost the race
+      return;
+    }
+
+    if (!ec) {
+      done_ = true;
+      timer_.cancel();
+      for (std::size_t i = 0; i < sockets_.size(); ++i) {
+        if (i != index && sockets_[i]) {
+          wintls::error_code ignored;
+          sockets_[i]->close(ignored);
+        }
+      }
+      return complete(ec, std::move(*sockets_[index]), endpoints_[index]);
+    }
+
+    last_error_ = ec;
+    sockets_[index].reset();
+    if (next_ < endpoints_.size()) {
+      // Start the next attempt right away instead of waiting for the delay
+      ++wait_generation_;
+      timer_.cancel();
+      start_next();
+    } else if (pending_ == 0) {
+      done_ = true;
+      complete(last_error_, Socket(executor_), endpoint_type{});
+    }
+  }
+
+  void complete(const wintls::error_code& ec, Socket socket, const endpoint_type& endpoint) {
+    auto ex = net::get_associated_executor(handler_, executor_);
+    net::dispatch(ex, [handler = std::move(handler_), ec, socket = std::move(socket), endpoint]() mutable {
+      handler(ec, std::move(socket), endpoint);
+    });
+    work_.reset();
+  }
+
+  executor_type executor_;
+  net::strand<executor_type> strand_;
+  std::vector<endpoint_type> endpoints_;
+  std::chrono::steady_clock::duration attempt_delay_;
+  net::steady_timer timer_;
+  net::executor_work_guard<executor_type> work_;
+  Handler handler_;
+  std::vector<std::unique_ptr<Socket>> sockets_;
+  std::size_t next_ = 0;
+  std::size_t pending_ = 0;
+  std::size_t wait_generation_ = 0;
+  wintls::error_code last_error_;
+  bool done_ = false;
+};
+
+template <class Socket, class Handler>
+void start_happy_eyeballs_race(const typename Socket::executor_type& executor,
+                               std::vector<typename Socket::endpoint_type> endpoints,
+                               std::chrono::steady_clock::duration attempt_delay,
+                               Handler&& handler) {
+  std::make_shared<happy_eyeballs_race<Socket, typename std::decay<Handler>::type>>(
+    executor, std::move(endpoints), attempt_delay, std::move(handler))->start();
+}
+
+// Connects using the happy eyeballs race, moves the connected socket
+// into the next layer of the stream and performs the client handshake
+template <class Stream>
+struct async_connect_and_handshake {
+  using socket_type = typename Stream::next_layer_type;
+  using endpoint_type = typename socket_type::endpoint_type;
+
+  template <typename Self>
+  void operator()(Self& self) {
+    if (endpoints_.empty()) {
+      auto e = self.get_executor();
+      net::post(e, [self = std::move(self)]() mutable {
+        self(wintls::error_code{net::error::host_not_found});
+      });
+      return;
+    }
+    start_happy_eyeballs_race<socket_type>(stream_.get_executor(),
+                                           interleave_address_families(endpoints_),
+                                           attempt_delay_,
+                                           std::move(self));
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec, socket_type socket, endpoint_type endpoint) {
+    if (ec) {
+      self.complete(ec, endpoint_type{});
+      return;
+    }
+    stream_.next_layer() = std::move(socket);
+    winner_ = endpoint;
+    stream_.async_handshake(handshake_type::client, std::move(self));
+  }
+
+  template <typename Self>
+  void operator()(Self& self, wintls::error_code ec) {
+    self.complete(ec, ec ? endpoint_type{} : winner_);
+  }
+
+  Stream& stream_;
+  std::vector<endpoint_type> endpoints_;
+  std::chrono::steady_clock::duration attempt_delay_;
+  endpoint_type winner_{};
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_HAPPY_EYEBALLS_HPP
@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_IDLE_CONNECTION_HPP
+#define WINTLS_DETAIL_IDLE_CONNECTION_HPP
+
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/sspi_stream.hpp>
+
+namespace wintls {
+namespace detail {
+
+// Checks whether an idle socket can still be used by peeking for data
+// without blocking. Nothing is expected to be received on an idle
+// connection, so both received data (most likely a TLS close_notify
+// alert) and end of file means the connection shouldn't be reused.
+template <class Protocol, class Executor>
+bool idle_connection_alive(net::basic_stream_socket<Protocol, Executor>& socket) {
+  if (!socket.is_open()) {
+    return false;
+  }
+  const bool was_non_blocking = socket.non_blocking();
+  wintls::error_code ec;
+  socket.non_blocking(true, ec);
+  if (ec) {
+    return false;
+  }
+  char data;
+  socket.receive(net::buffer(&data, 1), net::socket_base::message_peek, ec);
+  wintls::error_code ignored;
+  socket.non_blocking(was_non_blocking, ignored);
+  return ec == net::error::would_block;
+}
+
+// Other kinds of next layers can't be checked without blocking, so
+// assume they are still usable
+template <class NextLayer>
+bool idle_connection_alive(NextLayer&) {
+  return true;
+}
+
+// Checks whether an idle stream, given by its security state and next
+// layer, can be handed to a new user. An aborted stream has no
+// security state left.
+template <class NextLayer>
+bool idle_stream_reusable(const sspi_stream* sspi, NextLayer& next_layer) {
+  return sspi && sspi->idle() && idle_connection_alive(next_layer);
+}
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_IDLE_CONNECTION_HPP
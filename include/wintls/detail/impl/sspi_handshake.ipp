@@ -0,0 +1,248 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_IMPL_SSPI_HANDSHAKE_IPP
+#define WINTLS_DETAIL_IMPL_SSPI_HANDSHAKE_IPP
+
+#include <wintls/detail/sspi_handshake.hpp>
+
+namespace wintls {
+namespace detail {
+
+WINTLS_DECL SECURITY_STATUS sspi_handshake::acquire_credentials(handshake_type type) {
+  handshake_type_ = type;
+
+  SCHANNEL_CRED creds{};
+  creds.dwVersion = SCHANNEL_CRED_VERSION;
+  creds.grbitEnabledProtocols = static_cast<DWORD>(context_.method_);
+  creds.dwFlags = SCH_CRED_MANUAL_CRED_VALIDATION | SCH_CRED_NO_DEFAULT_CREDS;
+  // If revocation checking is enables, specify SCH_CRED_REVOCATION_CHECK_CHAIN_EXCLUDE_ROOT
+  // to cause the TLS certificate status request extension (commonly known as OCSP stapling)
+  // to be sent. This flag matches the CERT_CHAIN_REVOCATION_CHECK_CHAIN_EXCLUDE_ROOT
+  // flag that we pass to the CertGetCertificateChain calls during our manual authentication.
+  if (check_revocation_) {
+    creds.dwFlags |= SCH_CRED_REVOCATION_CHECK_CHAIN_EXCLUDE_ROOT;
+  }
+
+  auto usage = [this]() {
+    switch (handshake_type_) {
+      case handshake_type::client:
+        return SECPKG_CRED_OUTBOUND;
+      case handshake_type::server:
+        return SECPKG_CRED_INBOUND;
+    }
+    WINTLS_UNREACHABLE_RETURN(0);
+  }();
+
+  auto server_cert = context_.server_cert();
+  if (handshake_type_ == handshake_type::server && server_cert != nullptr) {
+    creds.cCreds = 1;
+    creds.paCred = &server_cert;
+  }
+
+  // TODO: rename server_cert field since it is also used for client cert.
+  // Note: if client cert is set, sspi will auto validate server cert with it.
+  // Even though verify_server_certificate_ in context is set to false.
+  if (handshake_type_ == handshake_type::client && server_cert != nullptr) {
+    creds.cCreds = 1;
+    creds.paCred = &server_cert;
+  }
+
+  auto acquire = [&](cred_handle& handle) {
+    ++context_.counters_->credentials_acquired;
+    TimeStamp expiry;
+    const bool had_credentials = handle;
+    const SECURITY_STATUS status = detail::sspi_functions::AcquireCredentialsHandle(nullptr,
+                                                                                   const_cast<SEC_CHAR*>(UNISP_NAME),
+                                                                                   static_cast<unsigned>(usage),
+                                                                                   nullptr,
+                                                                                   &creds,
+                                                                                   nullptr,
+                                                                                   nullptr,
+                                                                                   handle.get(),
+                                                                                   &expiry);
+    if (!had_credentials && handle) {
+      WINTLS_HANDLE_COUNTER_INCREMENT(cred_handle);
+    }
+    return status;
+  };
+  if (context_.credentials_cache_) {
+    SECURITY_STATUS status = SEC_E_OK;
+    cred_handle_.share(context_.credentials_cache_->get(static_cast<unsigned long>(usage), check_revocation_, status, acquire));
+    return status;
+  }
+  return acquire(cred_handle_);
+}
+
+WINTLS_DECL void sspi_handshake::operator()(handshake_type type) {
+  last_error_ = acquire_credentials(type);
+  if (last_error_ != SEC_E_OK) {
+    return;
+  }
+
+  switch(handshake_type_) {
+    case handshake_type::client: {
+      DWORD out_flags = 0;
+
+      handshake_output_buffers buffers;
+      const bool had_context = ctxt_handle_;
+      last_error_ = detail::sspi_functions::InitializeSecurityContext(cred_handle_.get(),
+                                                                      nullptr,
+                                                                      const_cast<SEC_CHAR*>(server_hostname_.c_str()),
+                                                                      client_flags(),
+                                                                      0,
+                                                                      SECURITY_NATIVE_DREP,
+                                                                      nullptr,
+                                                                      0,
+                                                                      ctxt_handle_.get(),
+                                                                      buffers.desc(),
+                                                                      &out_flags,
+                                                                      nullptr);
+      if (!had_context && ctxt_handle_) {
+        WINTLS_HANDLE_COUNTER_INCREMENT(ctxt_handle);
+      }
+      if (buffers[0].cbBuffer != 0 && buffers[0].pvBuffer != nullptr) {
+        out_buffer_ = sspi_context_buffer{buffers[0].pvBuffer, buffers[0].cbBuffer};
+      }
+      break;
+    }
+    case handshake_type::server:
+      last_error_ = SEC_I_CONTINUE_NEEDED;
+  }
+}
+
+WINTLS_DECL sspi_handshake::state sspi_handshake::operator()() {
+  if (last_error_ != SEC_I_CONTINUE_NEEDED && last_error_ != SEC_E_INCOMPLETE_MESSAGE &&
+      last_error_ != SEC_I_MESSAGE_FRAGMENT) {
+    return state::error;
+  }
+  if (!out_buffer_.empty()) {
+    return state::data_available;
+  }
+  // The rest of a fragmented DTLS message is produced without any input
+  if (input_buffers_[0].cbBuffer == 0 && last_error_ != SEC_I_MESSAGE_FRAGMENT) {
+    return state::data_needed;
+  }
+
+  handshake_output_buffers out_buffers;
+  DWORD out_flags = 0;
+
+  input_buffers_[1].BufferType = SECBUFFER_EMPTY;
+  input_buffers_[1].pvBuffer = nullptr;
+  input_buffers_[1].cbBuffer = 0;
+
+  switch(handshake_type_) {
+    case handshake_type::client:
+      last_error_ = detail::sspi_functions::InitializeSecurityContext(cred_handle_.get(),
+                                                                      ctxt_handle_.get(),
+                                                                      const_cast<SEC_CHAR*>(server_hostname_.c_str()),
+                                                                      client_flags(),
+                                                                      0,
+                                                                      SECURITY_NATIVE_DREP,
+                                                                      input_buffers_.desc(),
+                                                                      0,
+                                                                      nullptr,
+                                                                      out_buffers.desc(),
+                                                                      &out_flags,
+                                                                      nullptr);
+      break;
+    case handshake_type::server: {
+      TimeStamp expiry;
+      DWORD f_context_req = datagram_ ? server_datagram_context_flags : server_context_flags;
+      if (context_.verify_server_certificate_) {
+        f_context_req |= ASC_REQ_MUTUAL_AUTH;
+      }
+      const bool had_context = ctxt_handle_;
+      last_error_ = detail::sspi_functions::AcceptSecurityContext(cred_handle_.get(),
+                                                                  ctxt_handle_ ? ctxt_handle_.get() : nullptr,
+                                                                  input_buffers_.desc(),
+                                                                  f_context_req,
+                                                                  SECURITY_NATIVE_DREP,
+                                                                  ctxt_handle_.get(),
+                                                                  out_buffers.desc(),
+                                                                  &out_flags,
+                                                                  &expiry);
+      if (!had_context && ctxt_handle_) {
+        WINTLS_HANDLE_COUNTER_INCREMENT(ctxt_handle);
+      }
+    }
+  }
+  if (input_buffers_[1].BufferType == SECBUFFER_EXTRA) {
+    // Some data needs to be reused for the next call, move that to the front for reuse
+    const auto previous_size = input_buffers_[0].cbBuffer;
+    const auto extra_size = input_buffers_[1].cbBuffer;
+    const auto extra_data_begin = input_data_.begin() + previous_size - extra_size;
+    const auto extra_data_end = input_data_.begin() + previous_size;
+
+    std::move(extra_data_begin, extra_data_end, input_data_.begin());
+    input_buffers_[0].cbBuffer = extra_size;
+    in_buffer_ = net::buffer(input_data_) + extra_size;
+
+    WINTLS_ASSERT_MSG(in_buffer_.size() > 0, "buffer not large enough for tls handshake message");
+    return state::data_needed;
+  } else if (last_error_ == SEC_E_INCOMPLETE_MESSAGE) {
+    WINTLS_ASSERT_MSG(in_buffer_.size() > 0, "buffer not large enough for tls handshake message");
+    return state::data_needed;
+  } else {
+    input_buffers_[0].cbBuffer = 0;
+    in_buffer_ = net::buffer(input_data_);
+  }
+
+  bool has_buffer_output = out_buffers[0].cbBuffer != 0 && out_buffers[0].pvBuffer != nullptr;
+  if(has_buffer_output){
+    out_buffer_ = sspi_context_buffer{out_buffers[0].pvBuffer, out_buffers[0].cbBuffer};
+  }
+
+  switch (last_error_) {
+    case SEC_I_CONTINUE_NEEDED: {
+      return has_buffer_output ? state::data_available : state::data_needed;
+    }
+    case SEC_I_MESSAGE_FRAGMENT: {
+      // A DTLS handshake message larger than the MTU, to be sent in
+      // one datagram per fragment
+      return state::data_available;
+    }
+    case SEC_E_OK: {
+      // sspi handshake ok. perform manual auth here.
+      manual_auth();
+      if (handshake_type_ == handshake_type::client) {
+        if (last_error_ != SEC_E_OK) {
+          return state::error;
+        }
+      } else {
+        // Note: we are not checking (out_flags & ASC_RET_MUTUAL_AUTH) is true,
+        // but instead rely on our manual cert validation to establish trust.
+        // "The AcceptSecurityContext function will return ASC_RET_MUTUAL_AUTH if a
+        // client certificate was received from the client and schannel was
+        // successfully able to map the certificate to a user account in AD"
+        // As observed in tests, this check would wrongly reject openssl client with valid certificate.
+
+        // AcceptSecurityContext documentation:
+        // "If function generated an output token, the token must be sent to the client process."
+        // This happens when client cert is requested.
+        if (has_buffer_output) {
+          return last_error_ == SEC_E_OK ? state::done_with_data : state::error_with_data;
+        }
+      }
+      return state::done;
+    }
+
+    case SEC_I_INCOMPLETE_CREDENTIALS:
+      WINTLS_ASSERT_MSG(false, "client authentication not implemented");
+
+    case SEC_I_RENEGOTIATE:
+      WINTLS_ASSERT_MSG(false, "renegotiation not implemented");
+
+    default:
+      return state::error;
+  }
+}
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_IMPL_SSPI_HANDSHAKE_IPP
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_PENDING_BYTES_HPP
+#define WINTLS_DETAIL_PENDING_BYTES_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+
+namespace wintls {
+namespace detail {
+
+// Number of bytes buffered by a stream, updated by the decrypting and
+// encrypting side which may run on different threads, with optional
+// notification when the total crosses the water marks
+class pending_bytes {
+public:
+  void set_inbound(std::size_t plaintext, std::size_t ciphertext) {
+    plaintext_ = plaintext;
+    ciphertext_in_ = ciphertext;
+    check_watermarks();
+  }
+
+  void set_outbound(std::size_t ciphertext) {
+    ciphertext_out_ = ciphertext;
+    check_watermarks();
+  }
+
+  std::size_t plaintext() const {
+    return plaintext_;
+  }
+
+  std::size_t ciphertext_in() const {
+    return ciphertext_in_;
+  }
+
+  std::size_t ciphertext_out() const {
+    return ciphertext_out_;
+  }
+
+  void set_watermarks(std::size_t low, std::size_t high, std::function<void(bool)> handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    low_ = low;
+    high_ = high;
+    handler_ = std::move(handler);
+    above_ = false;
+    has_handler_ = static_cast<bool>(handler_);
+  }
+
+private:
+  void check_watermarks() {
+    if (!has_handler_) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!handler_) {
+      return;
+    }
+    const auto total = plaintext_ + ciphertext_in_ + ciphertext_out_;
+    if (!above_ && total >= high_) {
+      above_ = true;
+      handler_(true);
+    } else if (above_ && total <= low_) {
+      above_ = false;
+      handler_(false);
+    }
+  }
+
+  std::atomic<std::size_t> plaintext_{0};
+  std::atomic<std::size_t> ciphertext_in_{0};
+  std::atomic<std::size_t> ciphertext_out_{0};
+  std::atomic<bool> has_handler_{false};
+  std::mutex mutex_;
+  std::size_t low_ = 0;
+  std::size_t high_ = 0;
+  bool above_ = false;
+  std::function<void(bool)> handler_;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_PENDING_BYTES_HPP
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_READ_AHEAD_HPP
+#define WINTLS_DETAIL_READ_AHEAD_HPP
+
+#include <wintls/detail/config.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace wintls {
+namespace detail {
+
+// A read of the next layer started when a read operation completes,
+// so data keeps arriving while the application processes what it was
+// given. The data is read into a buffer owned by this object, which
+// the outstanding read keeps alive, as the stream may be destroyed
+// before the read completes.
+class read_ahead : public std::enable_shared_from_this<read_ahead> {
+public:
+  template <class Executor>
+  read_ahead(const Executor& executor, std::size_t max_size)
+    : max_size_(max_size)
+    , done_(executor) {
+  }
+
+  std::size_t max_size() const {
+    return max_size_;
+  }
+
+  void set_max_size(std::size_t max_size) {
+    max_size_ = max_size;
+  }
+
+  // Use the executor of a new next layer for waiting. No read must be
+  // in progress.
+  template <class Executor>
+  void set_executor(const Executor& executor) {
+    done_ = net::steady_timer(executor);
+  }
+
+  bool in_progress() const {
+    return in_progress_;
+  }
+
+  // True if data or an error from a completed read is waiting to be
+  // taken
+  bool completed() const {
+    return has_data() || ec_;
+  }
+
+  bool has_data() const {
+    return data_.size() != 0;
+  }
+
+  // Start reading, completing on the given executor which must be the
+  // one the stream is used from, like a strand
+  template <class NextLayer, class Executor>
+  void start(NextLayer& next_layer, const Executor& executor) {
+    if (max_size_ == 0 || in_progress_ || completed()) {
+      return;
+    }
+    buffer_.resize(max_size_);
+    in_progress_ = true;
+    next_layer.async_read_some(net::buffer(buffer_),
+                               net::bind_executor(executor, [self = shared_from_this()](const wintls::error_code& ec,
+                                                                                        std::size_t size) {
+      self->in_progress_ = false;
+      // A read cancelled after read ahead has been stopped isn't an
+      // error for the following reads
+      self->ec_ = (ec == net::error::operation_aborted && self->max_size_ == 0) ? wintls::error_code{} : ec;
+      self->data_ = net::buffer(self->buffer_.data(), size);
+      self->done_.cancel();
+    }));
+  }
+
+  // Wait for the outstanding read to complete. Always completes with
+  // operation_aborted which should be ignored.
+  template <class Handler>
+  void async_wait(Handler&& handler) {
+    done_.expires_at(net::steady_timer::time_point::max());
+    done_.async_wait(std::forward<Handler>(handler));
+  }
+
+  // Copy as much of the data read as fits in the given buffer, or
+  // return the error the read failed with once all data is taken
+  std::size_t take(const net::mutable_buffer& buffer, wintls::error_code& ec) {
+    if (data_.size() == 0) {
+      ec = ec_;
+      ec_ = {};
+      return 0;
+    }
+    const auto size = net::buffer_copy(buffer, data_);
+    data_ += size;
+    return size;
+  }
+
+private:
+  std::size_t max_size_;
+  bool in_progress_ = false;
+  wintls::error_code ec_;
+  net::const_buffer data_;
+  std::vector<char> buffer_;
+  net::steady_timer done_;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_READ_AHEAD_HPP
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_READ_SIZE_POLICY_HPP
+#define WINTLS_DETAIL_READ_SIZE_POLICY_HPP
+
+#include <wintls/read_statistics.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+namespace wintls {
+namespace detail {
+
+constexpr std::size_t min_adaptive_read_size = 0x400;
+constexpr std::size_t max_adaptive_read_size = 0x10000;
+
+// Decides how much of the free buffer space to offer to each read from
+// the next layer. Without adaptive sizing all of it is offered. With
+// it, reads start out sized for the records seen so far and grow while
+// they keep filling the space offered, like a bulk transfer does, and
+// shrink back when they don't, like an interactive connection with
+// small records does.
+class read_size_policy {
+public:
+  void set_adaptive(bool adaptive) {
+    adaptive_ = adaptive;
+    window_ = min_adaptive_read_size;
+  }
+
+  // The number of bytes to read given the free space, and the number
+  // of bytes known to be missing from the record being read, if any
+  std::size_t read_size(std::size_t available, std::size_t missing) {
+    std::size_t size = available;
+    if (adaptive_) {
+      size = std::min(available, std::max(window_, missing));
+    }
+    stats_.read_size = size;
+    return size;
+  }
+
+  void size_read(std::size_t size) {
+    ++stats_.reads;
+    stats_.bytes_read += size;
+    if (size != 0 && size == stats_.read_size) {
+      ++stats_.full_reads;
+      // More data is likely waiting
+      window_ = std::min(window_ * 2, max_adaptive_read_size);
+    } else {
+      window_ = std::max(min_adaptive_read_size, stats_.average_record_size);
+    }
+  }
+
+  void record_decrypted(std::size_t size) {
+    ++stats_.records;
+    if (stats_.average_record_size == 0) {
+      stats_.average_record_size = size;
+    } else {
+      stats_.average_record_size = (stats_.average_record_size * 7 + size) / 8;
+    }
+  }
+
+  const read_statistics& stats() const {
+    return stats_;
+  }
+
+private:
+  bool adaptive_ = false;
+  std::size_t window_ = min_adaptive_read_size;
+  read_statistics stats_{};
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_READ_SIZE_POLICY_HPP
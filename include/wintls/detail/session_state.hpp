@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_SESSION_STATE_HPP
+#define WINTLS_DETAIL_SESSION_STATE_HPP
+
+#include <wintls/handshake_type.hpp>
+
+#include <wintls/detail/config.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace wintls {
+namespace detail {
+
+// Serialized form of an established session:
+//
+//   magic "WTLS", version, handshake type (one byte each)
+//   length of the packed security context, the buffered ciphertext
+//   and the buffered plaintext (four byte little endian each)
+//   the packed security context, ciphertext and plaintext
+struct session_state {
+  handshake_type type;
+  net::const_buffer context_token;
+  net::const_buffer encrypted;
+  net::const_buffer decrypted;
+};
+
+constexpr std::array<char, 4> session_state_magic{{'W', 'T', 'L', 'S'}};
+constexpr char session_state_version = 1;
+constexpr std::size_t session_state_header_size = 6 + 3 * 4;
+
+inline void put_u32(std::vector<char>& out, std::size_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+inline std::uint32_t get_u32(const char* in) {
+  std::uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+  }
+  return value;
+}
+
+inline std::vector<char> serialize(const session_state& state) {
+  std::vector<char> out;
+  out.reserve(session_state_header_size + state.context_token.size() + state.encrypted.size() + state.decrypted.size());
+  out.insert(out.end(), session_state_magic.begin(), session_state_magic.end());
+  out.push_back(session_state_version);
+  out.push_back(static_cast<char>(state.type));
+  put_u32(out, state.context_token.size());
+  put_u32(out, state.encrypted.size());
+  put_u32(out, state.decrypted.size());
+  for (const auto& part : {state.context_token, state.encrypted, state.decrypted}) {
+    const auto data = static_cast<const char*>(part.data());
+    out.insert(out.end(), data, data + part.size());
+  }
+  return out;
+}
+
+// The buffers of the returned state refer to the given input
+inline bool deserialize(const net::const_buffer& in, session_state& state) {
+  const auto data = static_cast<const char*>(in.data());
+  if (in.size() < session_state_header_size ||
+      std::memcmp(data, session_state_magic.data(), session_state_magic.size()) != 0 ||
+      data[4] != session_state_version) {
+    return false;
+  }
+  switch (static_cast<handshake_type>(data[5])) {
+    case handshake_type::client:
+    case handshake_type::server:
+      state.type = static_cast<handshake_type>(data[5]);
+      break;
+    default:
+      return false;
+  }
+
+  const std::size_t token_size = get_u32(data + 6);
+  const std::size_t encrypted_size = get_u32(data + 10);
+  const std::size_t decrypted_size = get_u32(data + 14);
+  if (in.size() - session_state_header_size != token_size + encrypted_size + decrypted_size) {
+    return false;
+  }
+  const auto payload = data + session_state_header_size;
+  state.context_token = net::buffer(payload, token_size);
+  state.encrypted = net::buffer(payload + token_size, encrypted_size);
+  state.decrypted = net::buffer(payload + token_size + encrypted_size, decrypted_size);
+  return true;
+}
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_SESSION_STATE_HPP
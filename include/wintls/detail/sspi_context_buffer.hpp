@@ -8,6 +8,7 @@
 #ifndef WINTLS_DETAIL_SSPI_CONTEXT_BUFFER_HPP
 #define WINTLS_DETAIL_SSPI_CONTEXT_BUFFER_HPP
 
+#include <wintls/detail/handle_counter.hpp>
 #include <wintls/detail/sspi_functions.hpp>
 #include <wintls/detail/config.hpp>
 
@@ -28,17 +29,23 @@ public:
   }
 
   sspi_context_buffer& operator=(sspi_context_buffer&& other) {
-    buffer_ = other.buffer_;
-    other.buffer_ = net::const_buffer{};
+    if (this != &other) {
+      release();
+      buffer_ = other.buffer_;
+      other.buffer_ = net::const_buffer{};
+    }
     return *this;
   }
 
   sspi_context_buffer(const void* ptr, unsigned long size)
     : buffer_(ptr, size) {
+    if (buffer_.data() != nullptr) {
+      WINTLS_HANDLE_COUNTER_INCREMENT(sspi_context_buffer);
+    }
   }
 
   ~sspi_context_buffer() {
-    detail::sspi_functions::FreeContextBuffer(const_cast<void*>(buffer_.data()));
+    release();
   }
 
   net::const_buffer asio_buffer() const {
@@ -54,6 +61,14 @@ public:
   }
 
 private:
+  void release() {
+    if (buffer_.data() != nullptr) {
+      detail::sspi_functions::FreeContextBuffer(const_cast<void*>(buffer_.data()));
+      WINTLS_HANDLE_COUNTER_DECREMENT(sspi_context_buffer);
+    }
+    buffer_ = net::const_buffer{};
+  }
+
   net::const_buffer buffer_;
 };
 
@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_SSPI_DATAGRAM_HPP
+#define WINTLS_DETAIL_SSPI_DATAGRAM_HPP
+
+#include <wintls/detail/config.hpp>
+#include <wintls/detail/context_flags.hpp>
+#include <wintls/detail/decrypt_buffers.hpp>
+#include <wintls/detail/encrypt_buffers.hpp>
+#include <wintls/detail/sspi_functions.hpp>
+#include <wintls/detail/sspi_handshake.hpp>
+#include <wintls/detail/sspi_sec_handle.hpp>
+#include <wintls/detail/sspi_shutdown.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <vector>
+
+#ifndef SECPKG_ATTR_DTLS_MTU
+#define SECPKG_ATTR_DTLS_MTU 34
+#endif // SECPKG_ATTR_DTLS_MTU
+
+namespace wintls {
+namespace detail {
+
+// Datagrams small enough to not be fragmented on most paths over both
+// IPv4 and IPv6
+constexpr std::size_t default_datagram_mtu = 1200;
+
+// The TLS content type of handshake records
+constexpr unsigned char handshake_content_type = 22;
+
+// The DTLS counterpart of sspi_stream. Each datagram sent or received
+// holds a single record, which is encrypted or decrypted on its own.
+class sspi_datagram {
+public:
+  enum class decrypt_state {
+    data_available,
+    discarded,
+    error
+  };
+
+  sspi_datagram(context& ctx)
+    : handshake(ctx, ctxt_handle_, cred_handle_)
+    , shutdown(ctxt_handle_, cred_handle_, *ctx.counters_, client_datagram_context_flags)
+    , encrypt_buffers_(ctxt_handle_) {
+    handshake.set_datagram(true);
+  }
+
+  sspi_datagram(sspi_datagram&&) = delete;
+  sspi_datagram& operator=(sspi_datagram&&) = delete;
+
+  // The largest amount of data which can be sent in a single datagram
+  std::size_t max_message_size(wintls::error_code& ec) {
+    SECURITY_STATUS sc = SEC_E_OK;
+    const auto region = encrypt_buffers_.data_region(sc);
+    if (sc != SEC_E_OK) {
+      ec = error::make_error_code(sc);
+      return 0;
+    }
+    const auto overhead = encrypt_buffers_.overhead();
+    return mtu_ > overhead ? std::min(region.size(), mtu_ - overhead) : 0;
+  }
+
+  void set_mtu(std::size_t mtu, wintls::error_code& ec) {
+    mtu_ = mtu;
+    mtu_applied_ = false;
+    const SECURITY_STATUS sc = apply_mtu();
+    if (sc != SEC_E_OK) {
+      ec = error::make_error_code(sc);
+    }
+  }
+
+  // Let Schannel fragment the handshake messages after the MTU as
+  // well, which can only be done once the security context has been
+  // created by the first handshake call
+  SECURITY_STATUS apply_mtu() {
+    if (mtu_applied_ || !ctxt_handle_) {
+      return SEC_E_OK;
+    }
+    DWORD mtu = static_cast<DWORD>(mtu_);
+    const SECURITY_STATUS sc = detail::sspi_functions::SetContextAttributes(ctxt_handle_.get(), SECPKG_ATTR_DTLS_MTU, &mtu, sizeof(mtu));
+    mtu_applied_ = sc == SEC_E_OK;
+    return sc;
+  }
+
+  // Encrypt the data as a single record to be sent as a datagram
+  template <class ConstBufferSequence>
+  net::const_buffer encrypt(const ConstBufferSequence& buffers, wintls::error_code& ec) {
+    const auto max_size = max_message_size(ec);
+    if (ec) {
+      return {};
+    }
+    const auto size = net::buffer_size(buffers);
+    if (size > max_size) {
+      ec = net::error::message_size;
+      return {};
+    }
+    SECURITY_STATUS sc = SEC_E_OK;
+    net::buffer_copy(encrypt_buffers_.data_region(sc), buffers);
+    encrypt_buffers_.prepare(size);
+    sc = detail::sspi_functions::EncryptMessage(ctxt_handle_.get(), 0, encrypt_buffers_.desc(), 0);
+    if (sc != SEC_E_OK) {
+      ec = error::make_error_code(sc);
+      return {};
+    }
+    return encrypt_buffers_.record();
+  }
+
+  // Decrypt a datagram of the given size received into the receive
+  // buffer. Datagrams which can't be decrypted, like replayed or
+  // corrupted ones and handshake messages retransmitted by the peer,
+  // are discarded as required by DTLS.
+  template <class MutableBufferSequence>
+  decrypt_state decrypt(std::size_t size, const MutableBufferSequence& output, std::size_t& size_decrypted, wintls::error_code& ec) {
+    size_decrypted = 0;
+    decrypt_buffers_[0].BufferType = SECBUFFER_DATA;
+    decrypt_buffers_[0].pvBuffer = receive_buffer_.data();
+    decrypt_buffers_[0].cbBuffer = static_cast<unsigned long>(size);
+    decrypt_buffers_[1].BufferType = SECBUFFER_EMPTY;
+    decrypt_buffers_[2].BufferType = SECBUFFER_EMPTY;
+    decrypt_buffers_[3].BufferType = SECBUFFER_EMPTY;
+
+    const SECURITY_STATUS sc = detail::sspi_functions::DecryptMessage(ctxt_handle_.get(), decrypt_buffers_.desc(), 0, nullptr);
+    if (sc == SEC_I_CONTEXT_EXPIRED) {
+      ec = error::make_error_code(sc);
+      return decrypt_state::error;
+    }
+    if (sc != SEC_E_OK || decrypt_buffers_[1].BufferType != SECBUFFER_DATA) {
+      return decrypt_state::discarded;
+    }
+
+    const auto data = net::buffer(decrypt_buffers_[1].pvBuffer, decrypt_buffers_[1].cbBuffer);
+    size_decrypted = net::buffer_copy(output, data);
+    if (size_decrypted < data.size()) {
+      // Like receiving a datagram into a too small buffer
+      ec = net::error::message_size;
+    }
+    // The peer got our last handshake flight
+    flight_.clear();
+    return decrypt_state::data_available;
+  }
+
+  net::mutable_buffer receive_buffer() {
+    return net::buffer(receive_buffer_);
+  }
+
+  // True if the discarded datagram in the receive buffer was a
+  // handshake message, which the peer retransmits when it hasn't
+  // received our last handshake flight
+  bool received_handshake(std::size_t size) const {
+    return size != 0 && static_cast<unsigned char>(receive_buffer_[0]) == handshake_content_type;
+  }
+
+  // Keep a copy of each handshake datagram sent for retransmission. A
+  // new flight starts with the first datagram sent after receiving.
+  void handshake_sent(const net::const_buffer& datagram) {
+    if (flight_complete_) {
+      flight_.clear();
+      flight_complete_ = false;
+    }
+    const auto data = static_cast<const char*>(datagram.data());
+    flight_.emplace_back(data, data + datagram.size());
+  }
+
+  void handshake_flight_complete() {
+    flight_complete_ = true;
+  }
+
+  const std::vector<std::vector<char>>& flight() const {
+    return flight_;
+  }
+
+  std::chrono::steady_clock::duration retransmit_timeout = std::chrono::seconds(1);
+
+private:
+  ctxt_handle ctxt_handle_;
+  cred_handle cred_handle_;
+
+public:
+  sspi_handshake handshake;
+  sspi_shutdown shutdown;
+
+private:
+  encrypt_buffers encrypt_buffers_;
+  decrypt_buffers decrypt_buffers_;
+  std::array<char, 0x10000> receive_buffer_;
+  std::vector<std::vector<char>> flight_;
+  bool flight_complete_ = false;
+  std::size_t mtu_ = default_datagram_mtu;
+  bool mtu_applied_ = false;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_SSPI_DATAGRAM_HPP
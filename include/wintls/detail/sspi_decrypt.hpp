@@ -11,11 +11,13 @@
 #include <wintls/detail/config.hpp>
 #include <wintls/detail/sspi_functions.hpp>
 #include <wintls/detail/decrypt_buffers.hpp>
-#include <wintls/detail/decrypted_data_buffer.hpp>
+#include <wintls/detail/pending_bytes.hpp>
+#include <wintls/detail/read_size_policy.hpp>
 #include <wintls/detail/sspi_sec_handle.hpp>
 
 #include <array>
 #include <cstdint>
+#include <cstring>
 
 namespace wintls {
 namespace detail {
@@ -28,37 +30,113 @@ public:
     error
   };
 
-  sspi_decrypt(ctxt_handle& ctxt_handle)
+  sspi_decrypt(ctxt_handle& ctxt_handle, pending_bytes& pending)
     : size_decrypted(0)
     , input_buffer(net::buffer(encrypted_data_))
     , ctxt_handle_(ctxt_handle)
+    , pending_(pending)
     , last_error_(SEC_E_OK) {
     buffers_[0].pvBuffer = encrypted_data_.data();
   }
 
   template <class MutableBufferSequence>
   state operator()(const MutableBufferSequence& output_buffers) {
-    if (!decrypted_data_.empty()) {
-      size_decrypted = decrypted_data_.get(output_buffers);
+    const auto ret = decrypt(output_buffers);
+    update_pending();
+    return ret;
+  }
+
+  void size_read(std::size_t size) {
+    read_size.size_read(size);
+    buffers_[0].cbBuffer += static_cast<unsigned long>(size);
+    update_input_buffer();
+    update_pending();
+  }
+
+  // True if data has been received from the peer which hasn't been
+  // handed to the user yet
+  bool has_buffered_data() const {
+    return decrypted_data_.size() != 0 || buffers_[0].cbBuffer != 0;
+  }
+
+  // Received data which hasn't been decrypted yet
+  net::const_buffer encrypted_data() const {
+    return net::buffer(encrypted_data_.data() + encrypted_offset_, buffers_[0].cbBuffer);
+  }
+
+  // Decrypted data which hasn't been handed to the user yet
+  net::const_buffer decrypted_data() const {
+    return decrypted_data_;
+  }
+
+  // Restore the buffered data of a session moved from another stream
+  bool restore(const net::const_buffer& encrypted, const net::const_buffer& decrypted) {
+    if (encrypted.size() + decrypted.size() > encrypted_data_.size()) {
+      return false;
+    }
+    const auto decrypted_size = net::buffer_copy(net::buffer(encrypted_data_), decrypted);
+    decrypted_data_ = net::buffer(encrypted_data_.data(), decrypted_size);
+    encrypted_offset_ = decrypted_size;
+    buffers_[0].cbBuffer = static_cast<unsigned long>(
+      net::buffer_copy(net::buffer(encrypted_data_) + encrypted_offset_, encrypted));
+    update_input_buffer();
+    update_pending();
+    return true;
+  }
+
+  std::size_t size_decrypted;
+  net::mutable_buffer input_buffer;
+  read_size_policy read_size;
+
+  wintls::error_code last_error() const {
+    return error::make_error_code(last_error_);
+  }
+
+private:
+  static constexpr std::size_t buffer_size = 0x10000;
+
+  // SChannel decrypts records in place, so decrypted data which
+  // doesn't fit in the output buffers is handed out from where it was
+  // decrypted instead of being copied to a separate buffer. The
+  // ciphertext following it is only moved to the front of the buffer
+  // when more space is needed for reading the rest of a record.
+  template <class MutableBufferSequence>
+  state decrypt(const MutableBufferSequence& output_buffers) {
+    if (decrypted_data_.size() != 0) {
+      size_decrypted = net::buffer_copy(output_buffers, decrypted_data_);
+      decrypted_data_ += size_decrypted;
       return state::data_available;
     }
 
     if (buffers_[0].cbBuffer == 0) {
-      input_buffer = net::buffer(encrypted_data_);
+      encrypted_offset_ = 0;
+      missing_ = 0;
+      update_input_buffer();
       return state::data_needed;
     }
 
     buffers_[0].BufferType = SECBUFFER_DATA;
+    buffers_[0].pvBuffer = encrypted_data_.data() + encrypted_offset_;
     buffers_[1].BufferType = SECBUFFER_EMPTY;
     buffers_[2].BufferType = SECBUFFER_EMPTY;
     buffers_[3].BufferType = SECBUFFER_EMPTY;
 
-    input_buffer = net::buffer(encrypted_data_) + buffers_[0].cbBuffer;
     const auto size = buffers_[0].cbBuffer;
     last_error_ = detail::sspi_functions::DecryptMessage(ctxt_handle_.get(), buffers_.desc(), 0, nullptr);
 
     if (last_error_ == SEC_E_INCOMPLETE_MESSAGE) {
+      missing_ = 0;
+      for (std::size_t i = 1; i < 4; ++i) {
+        if (buffers_[i].BufferType == SECBUFFER_MISSING) {
+          missing_ = buffers_[i].cbBuffer;
+        }
+      }
       buffers_[0].cbBuffer = size;
+      if (encrypted_offset_ != 0) {
+        std::memmove(encrypted_data_.data(), encrypted_data_.data() + encrypted_offset_, size);
+        encrypted_offset_ = 0;
+      }
+      update_input_buffer();
       return state::data_needed;
     }
 
@@ -66,46 +144,48 @@ public:
       return state::error;
     }
 
+    const auto record_end = encrypted_offset_ + size;
     if (buffers_[1].BufferType == SECBUFFER_DATA) {
-      const auto data_ptr = reinterpret_cast<const char*>(buffers_[1].pvBuffer);
+      const auto data_ptr = reinterpret_cast<char*>(buffers_[1].pvBuffer);
       const auto data_size = buffers_[1].cbBuffer;
       size_decrypted = net::buffer_copy(output_buffers, net::buffer(data_ptr, data_size));
-      if (size_decrypted < data_size) {
-        decrypted_data_.fill(net::buffer(data_ptr + size_decrypted, data_size - size_decrypted));
-      }
+      decrypted_data_ = net::buffer(data_ptr + size_decrypted, data_size - size_decrypted);
     }
 
     if (buffers_[3].BufferType == SECBUFFER_EXTRA) {
       const auto extra_size = buffers_[3].cbBuffer;
-      std::memmove(encrypted_data_.data(), buffers_[3].pvBuffer, extra_size);
+      encrypted_offset_ = record_end - extra_size;
       buffers_[0].cbBuffer = extra_size;
+      read_size.record_decrypted(size - extra_size);
     } else {
+      encrypted_offset_ = record_end;
       buffers_[0].cbBuffer = 0;
+      read_size.record_decrypted(size);
     }
+    missing_ = 0;
+    update_input_buffer();
 
     return state::data_available;
   }
 
-  void size_read(std::size_t size) {
-    buffers_[0].cbBuffer += static_cast<unsigned long>(size);
-    input_buffer = net::buffer(encrypted_data_) + buffers_[0].cbBuffer;
+  // Received data is appended to the ciphertext not yet decrypted
+  void update_input_buffer() {
+    const auto free_space = net::buffer(encrypted_data_) + (encrypted_offset_ + buffers_[0].cbBuffer);
+    input_buffer = net::buffer(free_space, read_size.read_size(free_space.size(), missing_));
   }
 
-  std::size_t size_decrypted;
-  net::mutable_buffer input_buffer;
-
-  wintls::error_code last_error() const {
-    return error::make_error_code(last_error_);
+  void update_pending() {
+    pending_.set_inbound(decrypted_data_.size(), buffers_[0].cbBuffer);
   }
 
-private:
-  static constexpr std::size_t buffer_size = 0x10000;
-
   ctxt_handle& ctxt_handle_;
+  pending_bytes& pending_;
   SECURITY_STATUS last_error_;
   decrypt_buffers buffers_;
   std::array<char, buffer_size> encrypted_data_;
-  decrypted_data_buffer<buffer_size> decrypted_data_;
+  std::size_t encrypted_offset_ = 0;
+  std::size_t missing_ = 0;
+  net::const_buffer decrypted_data_;
 };
 
 } // namespace detail
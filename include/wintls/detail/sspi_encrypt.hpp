@@ -10,41 +10,157 @@
 
 #include <wintls/detail/config.hpp>
 #include <wintls/detail/encrypt_buffers.hpp>
+#include <wintls/detail/pending_bytes.hpp>
 #include <wintls/detail/sspi_sec_handle.hpp>
+#include <wintls/detail/token_bucket.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
 
 namespace wintls {
 namespace detail {
 
 class sspi_encrypt {
 public:
-  sspi_encrypt(ctxt_handle& ctxt_handle)
+  sspi_encrypt(ctxt_handle& ctxt_handle, pending_bytes& pending)
     : buffers(ctxt_handle)
-    , ctxt_handle_(ctxt_handle) {
+    , ctxt_handle_(ctxt_handle)
+    , pending_(pending) {
   }
 
+  // Encrypt as much of the data as fits in up to
+  // max_records_per_write records, which are written to the next
+  // layer with a single gather write to reduce the overhead per
+  // record
   template <typename ConstBufferSequence>
   std::size_t operator()(const ConstBufferSequence& buf, wintls::error_code& ec) {
     SECURITY_STATUS sc = SEC_E_OK;
-
-    std::size_t size_encrypted = buffers(buf, sc);
+    buffers.data_region(sc);
     if (sc != SEC_E_OK) {
       ec = error::make_error_code(sc);
       return 0;
     }
 
-    sc = detail::sspi_functions::EncryptMessage(ctxt_handle_.get(), 0, buffers.desc(), 0);
+    const std::size_t size = rate_limited_size(net::buffer_size(buf));
+    const auto max_message = buffers.max_message_size();
+    const auto records = std::max(std::size_t{1},
+                                  std::min(max_records_per_write, (size + max_message - 1) / max_message));
+    buffers.reserve_records(records);
+
+    output_ = {};
+    std::size_t size_encrypted = 0;
+    for (std::size_t record = 0; record < records; ++record) {
+      auto region = buffers.data_region(sc, record);
+      if (region.size() > size - size_encrypted) {
+        region = net::buffer(region.data(), size - size_encrypted);
+      }
+      const auto size_consumed = copy_from(region, buf, size_encrypted);
+      buffers.prepare(size_consumed, record);
+      sc = detail::sspi_functions::EncryptMessage(ctxt_handle_.get(), 0, buffers.desc(), 0);
+      if (sc != SEC_E_OK) {
+        ec = error::make_error_code(sc);
+        output_ = {};
+        return 0;
+      }
+      output_[record] = buffers.record();
+      size_encrypted += size_consumed;
+    }
+
+    encrypted();
+    return size_encrypted;
+  }
+
+  // The time to wait before a record with some of the given data can
+  // be written without exceeding the rate limit, if any. Waits for
+  // enough tokens for a reasonably sized record to avoid sending
+  // records with only a few bytes of data at low rates.
+  token_bucket::clock_type::duration write_delay(std::size_t size, wintls::error_code& ec) {
+    if (!rate_limit || size == 0) {
+      return token_bucket::clock_type::duration::zero();
+    }
+    SECURITY_STATUS sc = SEC_E_OK;
+    const auto region = buffers.data_region(sc);
     if (sc != SEC_E_OK) {
       ec = error::make_error_code(sc);
-      return 0;
+      return token_bucket::clock_type::duration::zero();
     }
+    constexpr std::size_t min_record_size = 1024;
+    const auto wanted = std::min(std::min(size, region.size()), min_record_size) + buffers.overhead();
+    return rate_limit->wait_time(std::min(wanted, rate_limit->burst()));
+  }
 
-    return size_encrypted;
+  // The part of the given size which can be sent within the budget of
+  // the rate limit, if any. At least one byte is allowed, so callers
+  // must wait for the write_delay first.
+  std::size_t rate_limited_size(std::size_t size) const {
+    if (!rate_limit) {
+      return size;
+    }
+    const auto budget = rate_limit->available() - static_cast<double>(buffers.overhead());
+    return std::min(size, budget < 1 ? std::size_t{1} : static_cast<std::size_t>(budget));
+  }
+
+  // Encrypt a record of the given size already placed in the data
+  // region of the buffers
+  void encrypt_in_place(std::size_t size, wintls::error_code& ec) {
+    buffers.prepare(size);
+    SECURITY_STATUS sc = detail::sspi_functions::EncryptMessage(ctxt_handle_.get(), 0, buffers.desc(), 0);
+    if (sc != SEC_E_OK) {
+      ec = error::make_error_code(sc);
+      return;
+    }
+    output_ = {};
+    output_[0] = buffers.record();
+    encrypted();
+  }
+
+  // The encrypted record has been written to the next layer, or
+  // failed to be written
+  void size_written() {
+    pending_.set_outbound(0);
+  }
+
+  // The encrypted records to write to the next layer, followed by
+  // empty buffers if fewer than the maximum number of records
+  const std::array<net::const_buffer, max_records_per_write>& output() const {
+    return output_;
   }
 
   encrypt_buffers buffers;
+  std::unique_ptr<token_bucket> rate_limit;
 
 private:
+  // Copy from the buffer sequence skipping the first offset bytes
+  template <typename ConstBufferSequence>
+  static std::size_t copy_from(net::mutable_buffer destination, const ConstBufferSequence& source, std::size_t offset) {
+    std::size_t size_copied = 0;
+    for (auto it = net::buffer_sequence_begin(source); it != net::buffer_sequence_end(source) && destination.size() != 0; ++it) {
+      net::const_buffer buffer = *it;
+      if (offset >= buffer.size()) {
+        offset -= buffer.size();
+        continue;
+      }
+      buffer += offset;
+      offset = 0;
+      const auto size = net::buffer_copy(destination, buffer);
+      destination += size;
+      size_copied += size;
+    }
+    return size_copied;
+  }
+
+  void encrypted() {
+    const auto size = net::buffer_size(output_);
+    if (rate_limit) {
+      rate_limit->consume(size);
+    }
+    pending_.set_outbound(size);
+  }
+
   ctxt_handle& ctxt_handle_;
+  pending_bytes& pending_;
+  std::array<net::const_buffer, max_records_per_write> output_;
 };
 
 } // namespace detail
@@ -84,6 +84,10 @@ inline SECURITY_STATUS QueryContextAttributes(PCtxtHandle phContext, unsigned lo
   return sspi_function_table()->QueryContextAttributes(phContext, ulAttribute, pBuffer);
 }
 
+inline SECURITY_STATUS SetContextAttributes(PCtxtHandle phContext, unsigned long ulAttribute, void* pBuffer, unsigned long cbBuffer) {
+  return sspi_function_table()->SetContextAttributes(phContext, ulAttribute, pBuffer, cbBuffer);
+}
+
 inline SECURITY_STATUS EncryptMessage(PCtxtHandle phContext, unsigned long fQOP, PSecBufferDesc pMessage, unsigned long MessageSeqNo) {
   return sspi_function_table()->EncryptMessage(phContext, fQOP, pMessage, MessageSeqNo);
 }
@@ -115,6 +119,14 @@ inline SECURITY_STATUS AcceptSecurityContext(PCredHandle phCredential,
                                                       pfContextAttr,
                                                       ptsExpiry);
 }
+
+inline SECURITY_STATUS ExportSecurityContext(PCtxtHandle phContext, unsigned long fFlags, PSecBuffer pPackedContext, void** pToken) {
+  return sspi_function_table()->ExportSecurityContext(phContext, fFlags, pPackedContext, pToken);
+}
+
+inline SECURITY_STATUS ImportSecurityContext(SEC_CHAR* pszPackage, PSecBuffer pPackedContext, void* Token, PCtxtHandle phContext) {
+  return sspi_function_table()->ImportSecurityContext(pszPackage, pPackedContext, Token, phContext);
+}
 } // namespace sspi_functions
 } // namespace detail
 } // namespace wintls
@@ -8,8 +8,11 @@
 #ifndef WINTLS_DETAIL_SSPI_SEC_HANDLE_HPP
 #define WINTLS_DETAIL_SSPI_SEC_HANDLE_HPP
 
+#include <wintls/detail/handle_counter.hpp>
 #include <wintls/detail/sspi_functions.hpp>
 
+#include <memory>
+
 namespace wintls {
 namespace detail {
 
@@ -35,20 +38,43 @@ private:
 
 class ctxt_handle : public sspi_sec_handle<CtxtHandle> {
 public:
+  ctxt_handle() = default;
+
   ~ctxt_handle() {
     if (*this) {
       detail::sspi_functions::DeleteSecurityContext(get());
+      WINTLS_HANDLE_COUNTER_DECREMENT(ctxt_handle);
     }
   }
 };
 
 class cred_handle : public sspi_sec_handle<CredHandle> {
 public:
+  cred_handle() = default;
+
   ~cred_handle() {
-    if (*this) {
-      detail::sspi_functions::FreeCredentialsHandle(get());
+    if (sspi_sec_handle::operator bool()) {
+      detail::sspi_functions::FreeCredentialsHandle(sspi_sec_handle::get());
+      WINTLS_HANDLE_COUNTER_DECREMENT(cred_handle);
     }
   }
+
+  // Use credentials shared with other streams instead of owning a
+  // separate handle
+  void share(std::shared_ptr<cred_handle> shared) {
+    shared_ = std::move(shared);
+  }
+
+  operator bool() {
+    return shared_ ? static_cast<bool>(*shared_) : sspi_sec_handle::operator bool();
+  }
+
+  CredHandle* get() {
+    return shared_ ? shared_->get() : sspi_sec_handle::get();
+  }
+
+private:
+  std::shared_ptr<cred_handle> shared_;
 };
 
 } // namespace detail
@@ -10,6 +10,7 @@
 
 #include <wintls/detail/sspi_functions.hpp>
 #include <wintls/detail/config.hpp>
+#include <wintls/detail/context_counters.hpp>
 #include <wintls/detail/context_flags.hpp>
 #include <wintls/detail/shutdown_buffers.hpp>
 #include <wintls/detail/sspi_context_buffer.hpp>
@@ -22,9 +23,14 @@ namespace detail {
 
 class sspi_shutdown {
 public:
-  sspi_shutdown(ctxt_handle& ctxt_handle, cred_handle& cred_handle)
+  sspi_shutdown(ctxt_handle& ctxt_handle,
+                cred_handle& cred_handle,
+                context_counters& counters,
+                DWORD context_flags = client_context_flags)
     : ctxt_handle_(ctxt_handle)
-    , cred_handle_(cred_handle) {
+    , cred_handle_(cred_handle)
+    , counters_(counters)
+    , context_flags_(context_flags) {
   }
 
   wintls::error_code operator()() {
@@ -39,7 +45,7 @@ public:
     sc = detail::sspi_functions::InitializeSecurityContext(cred_handle_.get(),
                                                            ctxt_handle_.get(),
                                                            nullptr,
-                                                           client_context_flags,
+                                                           context_flags_,
                                                            0,
                                                            SECURITY_NATIVE_DREP,
                                                            nullptr,
@@ -53,6 +59,7 @@ public:
     }
 
     buffer_ = sspi_context_buffer{buffers[0].pvBuffer, buffers[0].cbBuffer};
+    ++counters_.shutdowns;
     return {};
   }
 
@@ -69,6 +76,8 @@ public:
 private:
   ctxt_handle& ctxt_handle_;
   cred_handle& cred_handle_;
+  context_counters& counters_;
+  DWORD context_flags_;
   sspi_context_buffer buffer_;
 };
 
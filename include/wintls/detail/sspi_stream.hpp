@@ -13,6 +13,12 @@
 #include <wintls/detail/sspi_decrypt.hpp>
 #include <wintls/detail/sspi_shutdown.hpp>
 #include <wintls/detail/sspi_sec_handle.hpp>
+#include <wintls/detail/session_state.hpp>
+#include <wintls/detail/read_ahead.hpp>
+#include <wintls/detail/stream_registry.hpp>
+
+#include <memory>
+#include <vector>
 
 namespace wintls {
 namespace detail {
@@ -20,24 +26,139 @@ namespace detail {
 class sspi_stream {
 public:
   sspi_stream(context& ctx)
-    : handshake(ctx, ctxt_handle_, cred_handle_)
-    , encrypt(ctxt_handle_)
-    , decrypt(ctxt_handle_)
-    , shutdown(ctxt_handle_, cred_handle_) {
+    : counters_(*ctx.counters_)
+    , registry_(*ctx.registry_)
+    , handshake(ctx, ctxt_handle_, cred_handle_)
+    , encrypt(ctxt_handle_, pending)
+    , decrypt(ctxt_handle_, pending)
+    , shutdown(ctxt_handle_, cred_handle_, counters_) {
+    ++counters_.streams;
+    if (registry_.enabled()) {
+      registry_entry_ = std::make_shared<registry_entry>();
+      registry_.add(*registry_entry_);
+    }
+  }
+
+  ~sspi_stream() {
+    if (registry_entry_) {
+      registry_.remove(*registry_entry_);
+    }
+    --counters_.streams;
   }
 
   sspi_stream(sspi_stream&&) = delete;
   sspi_stream& operator=(sspi_stream&&) = delete;
 
+  // Serialize the established security context together with any
+  // data received but not yet read
+  SECURITY_STATUS export_session(std::vector<char>& out) {
+    SecBuffer packed{0, SECBUFFER_EMPTY, nullptr};
+    void* token = nullptr;
+    SECURITY_STATUS sc = detail::sspi_functions::ExportSecurityContext(ctxt_handle_.get(), 0, &packed, &token);
+    if (token != nullptr) {
+      CloseHandle(token);
+    }
+    if (sc != SEC_E_OK) {
+      return sc;
+    }
+    out = serialize(session_state{handshake.type(),
+                                  net::buffer(packed.pvBuffer, packed.cbBuffer),
+                                  decrypt.encrypted_data(),
+                                  decrypt.decrypted_data()});
+    detail::sspi_functions::FreeContextBuffer(packed.pvBuffer);
+    return SEC_E_OK;
+  }
+
+  // Restore a session serialized by export_session instead of
+  // performing a handshake
+  SECURITY_STATUS import_session(const net::const_buffer& in) {
+    session_state state{};
+    if (ctxt_handle_ || !deserialize(in, state)) {
+      return SEC_E_INVALID_TOKEN;
+    }
+
+    // Credentials are needed for shutting down the imported session
+    SECURITY_STATUS sc = handshake.acquire_credentials(state.type);
+    if (sc != SEC_E_OK) {
+      return sc;
+    }
+
+    std::vector<char> token{static_cast<const char*>(state.context_token.data()),
+                            static_cast<const char*>(state.context_token.data()) + state.context_token.size()};
+    SecBuffer packed{static_cast<unsigned long>(token.size()), SECBUFFER_EMPTY, token.data()};
+    sc = detail::sspi_functions::ImportSecurityContext(const_cast<SEC_CHAR*>(UNISP_NAME), &packed, nullptr, ctxt_handle_.get());
+    if (ctxt_handle_) {
+      WINTLS_HANDLE_COUNTER_INCREMENT(ctxt_handle);
+    }
+    if (sc != SEC_E_OK) {
+      return sc;
+    }
+
+    if (!decrypt.restore(state.encrypted, state.decrypted)) {
+      return SEC_E_INVALID_TOKEN;
+    }
+    return SEC_E_OK;
+  }
+
+  // Move the data of a completed read ahead to the input buffer, so
+  // it is kept when the state is exported or moved. Fails with
+  // in_progress if a read ahead is still outstanding, as the data it
+  // reads would be lost.
+  wintls::error_code take_read_ahead() {
+    if (!read_ahead) {
+      return {};
+    }
+    if (read_ahead->in_progress()) {
+      return net::error::in_progress;
+    }
+    while (read_ahead->has_data()) {
+      wintls::error_code ec{};
+      const auto size = read_ahead->take(decrypt.input_buffer, ec);
+      if (size == 0) {
+        return net::error::no_buffer_space;
+      }
+      decrypt.size_read(size);
+    }
+    return {};
+  }
+
+  // True if nothing has been received which the application hasn't
+  // read, neither decrypted data nor data of a read ahead, and no read
+  // ahead is outstanding, so the stream can be handed to a new user
+  bool idle() const {
+    return !decrypt.has_buffered_data() && (!read_ahead || (!read_ahead->in_progress() && !read_ahead->completed()));
+  }
+
+  // Count an abortive close of the stream, which is done by
+  // destroying the security context and buffers
+  void aborted() {
+    ++counters_.aborts;
+  }
+
+  // Update the stream owning the state in the registry of the context
+  void attach(void* owner,
+              registry_entry::post_function post_function,
+              registry_entry::shutdown_function shutdown_function,
+              registry_entry::close_function close_function) {
+    if (registry_entry_) {
+      registry_.attach(*registry_entry_, owner, post_function, shutdown_function, close_function);
+    }
+  }
+
 private:
   ctxt_handle ctxt_handle_;
   cred_handle cred_handle_;
+  context_counters& counters_;
+  stream_registry& registry_;
+  std::shared_ptr<registry_entry> registry_entry_;
 
 public:
+  pending_bytes pending;
   sspi_handshake handshake;
   sspi_encrypt encrypt;
   sspi_decrypt decrypt;
   sspi_shutdown shutdown;
+  std::shared_ptr<detail::read_ahead> read_ahead;
 };
 
 } // namespace detail
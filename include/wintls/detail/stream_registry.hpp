@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_STREAM_REGISTRY_HPP
+#define WINTLS_DETAIL_STREAM_REGISTRY_HPP
+
+#include <wintls/detail/config.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace wintls {
+namespace detail {
+
+// Links a live stream into the registry of its context. Owned by the
+// TLS state of the stream, and kept alive by a drain in progress which
+// only uses the stream after checking that it still exists.
+struct registry_entry : std::enable_shared_from_this<registry_entry> {
+  using post_function = void (*)(void* owner, std::function<void()> function);
+  using shutdown_function = void (*)(void* owner, std::function<void(const wintls::error_code&)> done);
+  using close_function = void (*)(void* owner);
+
+  registry_entry* prev = nullptr;
+  registry_entry* next = nullptr;
+
+  // The stream currently holding the state, which changes when the
+  // stream is moved, and the functions for operating on it
+  void* owner = nullptr;
+  post_function post = nullptr;
+  shutdown_function shutdown = nullptr;
+  close_function close = nullptr;
+};
+
+// Intrusive list of the live streams of a context. Registering and
+// unregistering only relinks a few pointers while holding the lock.
+// Streams are only registered once enabled, so contexts never drained
+// don't pay for it.
+class stream_registry {
+public:
+  bool enabled() const {
+    return enabled_;
+  }
+
+  void enable(bool enabled) {
+    enabled_ = enabled;
+  }
+
+  void add(registry_entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry.next = head_;
+    if (head_ != nullptr) {
+      head_->prev = &entry;
+    }
+    head_ = &entry;
+    ++size_;
+  }
+
+  void remove(registry_entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entry.prev != nullptr) {
+      entry.prev->next = entry.next;
+    } else {
+      head_ = entry.next;
+    }
+    if (entry.next != nullptr) {
+      entry.next->prev = entry.prev;
+    }
+    entry.prev = entry.next = nullptr;
+    entry.owner = nullptr;
+    --size_;
+  }
+
+  void attach(registry_entry& entry,
+              void* owner,
+              registry_entry::post_function post_function,
+              registry_entry::shutdown_function shutdown_function,
+              registry_entry::close_function close_function) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry.owner = owner;
+    entry.post = post_function;
+    entry.shutdown = shutdown_function;
+    entry.close = close_function;
+  }
+
+  std::vector<std::shared_ptr<registry_entry>> entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::shared_ptr<registry_entry>> result;
+    result.reserve(size_);
+    for (auto entry = head_; entry != nullptr; entry = entry->next) {
+      result.push_back(entry->shared_from_this());
+    }
+    return result;
+  }
+
+  // Post the function to the executor of the stream, which runs it
+  // with the stream, or null if it has been destroyed in the
+  // meantime. Returns false without posting if the stream has already
+  // been destroyed.
+  bool post(const std::shared_ptr<registry_entry>& entry,
+            std::function<void(registry_entry*)> function) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entry->owner == nullptr) {
+      return false;
+    }
+    // Posting never runs the function inline, so the lock is released
+    // before it runs
+    entry->post(entry->owner, [this, entry, function = std::move(function)]() {
+      bool alive = false;
+      {
+        std::lock_guard<std::mutex> alive_lock(mutex_);
+        alive = entry->owner != nullptr;
+      }
+      function(alive ? entry.get() : nullptr);
+    });
+    return true;
+  }
+
+private:
+  std::atomic<bool> enabled_{false};
+  mutable std::mutex mutex_;
+  registry_entry* head_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_STREAM_REGISTRY_HPP
@@ -0,0 +1,209 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_SYNC_DEADLINE_HPP
+#define WINTLS_DETAIL_SYNC_DEADLINE_HPP
+
+#include <wintls/detail/config.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <climits>
+#include <thread>
+#include <utility>
+
+namespace wintls {
+namespace detail {
+
+// Blocking operations on the next layer without a deadline
+struct no_deadline {
+};
+
+using deadline = std::chrono::steady_clock::time_point;
+
+template <class SyncStream, class MutableBufferSequence>
+std::size_t sync_read_some(SyncStream& next_layer, const MutableBufferSequence& buffers, no_deadline, wintls::error_code& ec) {
+  return next_layer.read_some(buffers, ec);
+}
+
+template <class SyncStream, class ConstBufferSequence>
+std::size_t sync_write(SyncStream& next_layer, const ConstBufferSequence& buffers, no_deadline, wintls::error_code& ec) {
+  return net::write(next_layer, buffers, ec);
+}
+
+template <class Duration>
+void sync_sleep_for(const Duration& delay, no_deadline, wintls::error_code&) {
+  std::this_thread::sleep_for(delay);
+}
+
+// The socket at the bottom of the next layer, for asio sockets and
+// layers on top of them, or streams owning a socket like
+// beast::tcp_stream
+template <class SyncStream>
+auto lowest_socket(SyncStream& next_layer, int) -> decltype(next_layer.lowest_layer()) {
+  return next_layer.lowest_layer();
+}
+
+template <class SyncStream>
+auto lowest_socket(SyncStream& next_layer, long) -> decltype(next_layer.socket()) {
+  return next_layer.socket();
+}
+
+// Wait until the socket is ready for the given events, or fail with
+// timed_out when the deadline is reached first
+template <class Socket>
+void wait_until(Socket& socket, short events, deadline until, wintls::error_code& ec) {
+  const auto now = std::chrono::steady_clock::now();
+  if (now >= until) {
+    ec = net::error::timed_out;
+    return;
+  }
+  // Round up to not wake up just before the deadline
+  const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count() + 1;
+
+  WSAPOLLFD fd{};
+  fd.fd = socket.native_handle();
+  fd.events = events;
+  const int result = WSAPoll(&fd, 1, static_cast<INT>(std::min<long long>(timeout, INT_MAX)));
+  if (result == SOCKET_ERROR) {
+    ec = wintls::error_code(WSAGetLastError(), wintls::system_category());
+    return;
+  }
+  if (result == 0) {
+    ec = net::error::timed_out;
+  }
+  // Errors and hangups are reported by the following read or write
+}
+
+// Read once the socket is readable, which doesn't block as the
+// socket has data or has been closed by then
+template <class SyncStream, class MutableBufferSequence>
+std::size_t sync_read_some(SyncStream& next_layer, const MutableBufferSequence& buffers, deadline until, wintls::error_code& ec) {
+  wait_until(lowest_socket(next_layer, 0), POLLRDNORM, until, ec);
+  if (ec) {
+    return 0;
+  }
+  return next_layer.read_some(buffers, ec);
+}
+
+// The part of a buffer sequence not written yet, which hands out the
+// next few buffers at a time without allocating
+template <class ConstBufferSequence>
+class consuming_buffers {
+public:
+  static constexpr std::size_t max_buffers = 16;
+
+  struct prepared_buffers {
+    const net::const_buffer* begin() const {
+      return buffers.data();
+    }
+
+    const net::const_buffer* end() const {
+      return buffers.data() + count;
+    }
+
+    std::array<net::const_buffer, max_buffers> buffers;
+    std::size_t count;
+  };
+
+  explicit consuming_buffers(const ConstBufferSequence& buffers)
+    : next_(net::buffer_sequence_begin(buffers))
+    , end_(net::buffer_sequence_end(buffers)) {
+    // Skip leading empty buffers
+    consume(0);
+  }
+
+  bool empty() const {
+    return next_ == end_;
+  }
+
+  prepared_buffers prepare() const {
+    prepared_buffers result{};
+    for (auto it = next_; it != end_ && result.count < max_buffers; ++it) {
+      net::const_buffer buffer(*it);
+      if (it == next_) {
+        buffer += offset_;
+      }
+      result.buffers[result.count++] = buffer;
+    }
+    return result;
+  }
+
+  void consume(std::size_t size) {
+    for (; next_ != end_; ++next_) {
+      const auto remaining = net::const_buffer(*next_).size() - offset_;
+      if (size < remaining) {
+        offset_ += size;
+        return;
+      }
+      size -= remaining;
+      offset_ = 0;
+    }
+  }
+
+private:
+  using iterator = decltype(net::buffer_sequence_begin(std::declval<const ConstBufferSequence&>()));
+
+  iterator next_;
+  iterator end_;
+  std::size_t offset_ = 0;
+};
+
+// Write in non-blocking mode, as a blocking write of more than fits
+// in the send buffer of the socket would wait for the peer regardless
+// of the deadline
+template <class SyncStream, class ConstBufferSequence>
+std::size_t sync_write(SyncStream& next_layer, const ConstBufferSequence& buffers, deadline until, wintls::error_code& ec) {
+  auto& socket = lowest_socket(next_layer, 0);
+  const bool was_non_blocking = socket.non_blocking();
+  if (!was_non_blocking) {
+    socket.non_blocking(true, ec);
+    if (ec) {
+      return 0;
+    }
+  }
+
+  consuming_buffers<ConstBufferSequence> remaining(buffers);
+  std::size_t size_written = 0;
+  while (!remaining.empty()) {
+    const std::size_t size = next_layer.write_some(remaining.prepare(), ec);
+    if (ec == net::error::would_block) {
+      ec = {};
+      wait_until(socket, POLLWRNORM, until, ec);
+      if (ec) {
+        break;
+      }
+      continue;
+    }
+    if (ec) {
+      break;
+    }
+    size_written += size;
+    remaining.consume(size);
+  }
+
+  if (!was_non_blocking) {
+    wintls::error_code ignored{};
+    socket.non_blocking(false, ignored);
+  }
+  return size_written;
+}
+
+template <class Duration>
+void sync_sleep_for(const Duration& delay, deadline until, wintls::error_code& ec) {
+  if (std::chrono::steady_clock::now() + delay > until) {
+    ec = net::error::timed_out;
+    return;
+  }
+  std::this_thread::sleep_for(delay);
+}
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_SYNC_DEADLINE_HPP
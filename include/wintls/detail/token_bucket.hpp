@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_DETAIL_TOKEN_BUCKET_HPP
+#define WINTLS_DETAIL_TOKEN_BUCKET_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+namespace wintls {
+namespace detail {
+
+// Token bucket with one token per byte, refilled continuously at the
+// given rate up to the burst size. The number of tokens can become
+// negative when consuming more than available, which is paid back
+// before more data can be sent.
+class token_bucket {
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  token_bucket(std::size_t rate, std::size_t burst)
+    : rate_(static_cast<double>(rate))
+    , burst_(static_cast<double>(burst))
+    , tokens_(static_cast<double>(burst))
+    , last_refill_(clock_type::now()) {
+  }
+
+  double available() {
+    refill();
+    return tokens_;
+  }
+
+  std::size_t burst() const {
+    return static_cast<std::size_t>(burst_);
+  }
+
+  // The time until the given number of tokens are available
+  clock_type::duration wait_time(std::size_t tokens) {
+    refill();
+    const auto missing = static_cast<double>(tokens) - tokens_;
+    if (missing <= 0) {
+      return clock_type::duration::zero();
+    }
+    return std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(missing / rate_)) +
+           clock_type::duration{1};
+  }
+
+  void consume(std::size_t tokens) {
+    tokens_ -= static_cast<double>(tokens);
+  }
+
+private:
+  void refill() {
+    const auto now = clock_type::now();
+    const std::chrono::duration<double> elapsed = now - last_refill_;
+    tokens_ = std::min(burst_, tokens_ + elapsed.count() * rate_);
+    last_refill_ = now;
+  }
+
+  double rate_;
+  double burst_;
+  double tokens_;
+  clock_type::time_point last_refill_;
+};
+
+} // namespace detail
+} // namespace wintls
+
+#endif // WINTLS_DETAIL_TOKEN_BUCKET_HPP
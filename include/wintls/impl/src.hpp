@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_IMPL_SRC_HPP
+#define WINTLS_IMPL_SRC_HPP
+
+// Include in exactly one translation unit of a program defining
+// WINTLS_SEPARATE_COMPILATION, or build the wintls library target with
+// the ENABLE_WINTLS_SEPARATE_COMPILATION CMake option.
+
+#include <wintls/detail/config.hpp>
+
+#if WINTLS_HEADER_ONLY
+#error Do not compile the wintls library source without WINTLS_SEPARATE_COMPILATION defined
+#endif // WINTLS_HEADER_ONLY
+
+#include <wintls/context.hpp>
+#include <wintls/stream.hpp>
+
+#ifndef WINTLS_USE_STANDALONE_ASIO
+#include <wintls/beast.hpp>
+#endif // !WINTLS_USE_STANDALONE_ASIO
+
+#include <wintls/impl/certificate.ipp>
+#include <wintls/detail/impl/context_certificates.ipp>
+#include <wintls/detail/impl/sspi_handshake.ipp>
+
+namespace wintls {
+
+template class stream<net::ip::tcp::socket>;
+#ifndef WINTLS_USE_STANDALONE_ASIO
+template class stream<boost::beast::tcp_stream>;
+#endif // !WINTLS_USE_STANDALONE_ASIO
+
+} // namespace wintls
+
+#endif // WINTLS_IMPL_SRC_HPP
@@ -34,6 +34,14 @@
 #define SP_PROT_TLS1_3_CLIENT 0x2000
 #endif // SP_PROT_TLS1_3_CLIENT
 
+#ifndef SP_PROT_DTLS1_2_SERVER
+#define SP_PROT_DTLS1_2_SERVER 0x40000
+#endif // SP_PROT_DTLS1_2_SERVER
+
+#ifndef SP_PROT_DTLS1_2_CLIENT
+#define SP_PROT_DTLS1_2_CLIENT 0x80000
+#endif // SP_PROT_DTLS1_2_CLIENT
+
 namespace wintls {
 
 /// Different methods supported by a context.
@@ -84,7 +92,16 @@ enum class method {
   tlsv13_client = SP_PROT_TLS1_3_CLIENT,
 
   /// TLS version 1.3 server.
-  tlsv13_server = SP_PROT_TLS1_3_SERVER
+  tlsv13_server = SP_PROT_TLS1_3_SERVER,
+
+  /// Generic DTLS version 1.2, for use with a @ref datagram_stream.
+  dtlsv12 = SP_PROT_DTLS1_2_SERVER | SP_PROT_DTLS1_2_CLIENT,
+
+  /// DTLS version 1.2 client, for use with a @ref datagram_stream.
+  dtlsv12_client = SP_PROT_DTLS1_2_CLIENT,
+
+  /// DTLS version 1.2 server, for use with a @ref datagram_stream.
+  dtlsv12_server = SP_PROT_DTLS1_2_SERVER
 };
 
 } // namespace wintls
@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_READ_STATISTICS_HPP
+#define WINTLS_READ_STATISTICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wintls {
+
+/** Statistics about how a @ref stream reads from its next layer.
+ */
+struct read_statistics {
+  /// The number of reads from the next layer.
+  std::uint64_t reads;
+  /// The number of bytes read from the next layer.
+  std::uint64_t bytes_read;
+  /// The number of reads which filled all of the space offered.
+  std::uint64_t full_reads;
+  /// The number of TLS records decrypted.
+  std::uint64_t records;
+  /// The average size of the TLS records decrypted, weighted towards the most recent ones.
+  std::size_t average_record_size;
+  /// The number of bytes offered to the most recent read from the next layer.
+  std::size_t read_size;
+};
+
+} // namespace wintls
+
+#endif // WINTLS_READ_STATISTICS_HPP
@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_RELAY_HPP
+#define WINTLS_RELAY_HPP
+
+#include <wintls/stream.hpp>
+
+#include <wintls/detail/async_relay.hpp>
+#include <wintls/detail/config.hpp>
+
+namespace wintls {
+
+/** Start an asynchronous operation relaying data between two streams.
+ *
+ * Data read from each stream is written to the other until both
+ * peers have finished sending, like in a TLS terminating proxy. When
+ * a peer closes the connection, a TLS shutdown is performed on the
+ * other stream.
+ *
+ * Each record is decrypted directly into the record buffer of the
+ * other stream and encrypted in place there, so the plaintext is
+ * copied once instead of twice compared to reading into and writing
+ * from a user buffer. Both directions run concurrently with a single
+ * record in flight each, so reading from a stream pauses until the
+ * data has been written to the other. The handlers of both directions
+ * run on a single strand of the executor of the first stream. A write
+ * rate limit set on a stream applies to the data relayed to it.
+ *
+ * The handshake must have been completed on both streams and no other
+ * operations must be performed on them until the operation completes.
+ * If one direction fails, the operation waits for the other direction
+ * to complete as well, which can be forced by closing the next layers.
+ *
+ * @param a The first stream.
+ * @param b The second stream.
+ * @param handler The handler to be called when the operation
+ * completes. The equivalent function signature of the handler must
+ * be:
+ * @code
+ * void handler(
+ *     wintls::error_code // Result of operation, the first error of either direction.
+ * );
+ * @endcode
+ */
+template <class NextLayerA, class NextLayerB, class CompletionToken>
+auto async_relay(stream<NextLayerA>& a, stream<NextLayerB>& b, CompletionToken&& handler) {
+  return net::async_initiate<CompletionToken, void(wintls::error_code)>(
+      detail::relay_initiation{}, handler, &a, &b);
+}
+
+} // namespace wintls
+
+#endif // WINTLS_RELAY_HPP
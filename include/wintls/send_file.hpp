@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef WINTLS_SEND_FILE_HPP
+#define WINTLS_SEND_FILE_HPP
+
+#include <wintls/stream.hpp>
+
+#include <wintls/detail/async_send_file.hpp>
+#include <wintls/detail/config.hpp>
+
+#include <cstdint>
+
+namespace wintls {
+
+/** Start an asynchronous operation sending part of a file on a stream.
+ *
+ * The file is read directly into the record buffer of the stream and
+ * encrypted in place there, so the data isn't copied through an
+ * intermediate buffer as when reading the file and writing it to the
+ * stream. A write rate limit set on the stream applies the same way
+ * as to write operations.
+ *
+ * No other write operations must be performed on the stream until
+ * the operation completes.
+ *
+ * @param s The stream to send the file on.
+ * @param file The file to send. Must support random access reads
+ * using `async_read_some_at`, like `net::windows::random_access_handle`
+ * or `net::random_access_file`. Must remain valid until the operation
+ * completes.
+ * @param offset The offset in the file to start sending from.
+ * @param size The number of bytes to send. Sending stops at the end
+ * of the file if it is reached first.
+ * @param handler The handler to be called when the operation
+ * completes. The equivalent function signature of the handler must
+ * be:
+ * @code
+ * void handler(
+ *     wintls::error_code, // Result of operation.
+ *     std::uint64_t       // Number of bytes of the file sent.
+ * );
+ * @endcode
+ */
+template <class NextLayer, class File, class CompletionToken>
+auto async_send_file(stream<NextLayer>& s, File& file, std::uint64_t offset, std::uint64_t size, CompletionToken&& handler) {
+  return net::async_initiate<CompletionToken, void(wintls::error_code, std::uint64_t)>(
+      detail::send_file_initiation{}, handler, &s, &file, offset, size);
+}
+
+} // namespace wintls
+
+#endif // WINTLS_SEND_FILE_HPP
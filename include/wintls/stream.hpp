@@ -10,13 +10,16 @@
 
 #include <wintls/error.hpp>
 #include <wintls/handshake_type.hpp>
+#include <wintls/read_statistics.hpp>
 
 #include <wintls/detail/assert.hpp>
 #include <wintls/detail/async_handshake.hpp>
 #include <wintls/detail/async_read.hpp>
 #include <wintls/detail/async_shutdown.hpp>
+#include <wintls/detail/async_stop_read_ahead.hpp>
 #include <wintls/detail/async_write.hpp>
 #include <wintls/detail/sspi_stream.hpp>
+#include <wintls/detail/sync_deadline.hpp>
 
 #ifdef WINTLS_USE_STANDALONE_ASIO
 #include <asio/compose.hpp>
@@ -26,10 +29,26 @@
 #include <boost/asio/io_context.hpp>
 #endif // !WINTLS_USE_STANDALONE_ASIO
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace wintls {
 
+namespace detail {
+struct relay_initiation;
+struct send_file_initiation;
+} // namespace detail
+
+template <class NextLayer>
+class connection_pool;
+
+template <class NextLayer>
+class connection_reservoir;
+
 /** Provides stream-oriented functionality using Windows SSPI/Schannel.
  *
  * The stream class template provides asynchronous and blocking
@@ -63,6 +82,84 @@ public:
   stream(Arg&& arg, context& ctx)
     : next_layer_(std::forward<Arg>(arg))
     , sspi_stream_(std::make_unique<detail::sspi_stream>(ctx)) {
+    attach();
+  }
+
+  /** Move construct a stream.
+   *
+   * The moved from stream must not be used afterwards, except for
+   * being destroyed or assigned to.
+   */
+  stream(stream&& other)
+    : next_layer_(std::forward<NextLayer>(other.next_layer_))
+    , sspi_stream_(std::move(other.sspi_stream_)) {
+    attach();
+  }
+
+  /** Move assign a stream.
+   *
+   * Only available if the next layer is move assignable. The moved
+   * from stream must not be used afterwards, except for being
+   * destroyed or assigned to.
+   */
+  template <class T = NextLayer,
+            typename std::enable_if<std::is_move_assignable<T>::value && !std::is_reference<T>::value, int>::type = 0>
+  stream& operator=(stream<T>&& other) {
+    next_layer_ = std::move(other.next_layer_);
+    sspi_stream_ = std::move(other.sspi_stream_);
+    attach();
+    return *this;
+  }
+
+  /// Rebinds the stream type to another executor.
+  template <class Executor>
+  struct rebind_executor {
+    /// The stream type when rebound to the specified executor.
+    using other = stream<typename next_layer_type::template rebind_executor<Executor>::other>;
+  };
+
+  /** Move the TLS state of the stream onto a new next layer.
+   *
+   * Creates a new stream using the given next layer, taking over the
+   * established security context and any data received but not yet
+   * read from this stream. No new handshake is performed.
+   *
+   * This allows moving an established connection to another
+   * executor, like handing accepted connections to the least loaded
+   * of a number of per-core io_contexts. The connection itself must
+   * have been moved to the new next layer by the caller, for a socket
+   * by releasing the native handle and assigning it to a socket
+   * using the new executor:
+   * @code
+   * auto protocol = s.next_layer().local_endpoint().protocol();
+   * auto handle = s.next_layer().release();
+   * auto moved = s.release_and_rebind(net::ip::tcp::socket{worker_executor, protocol, handle});
+   * @endcode
+   *
+   * No operations must be outstanding on this stream. If read ahead
+   * is used, it must be stopped using @ref async_stop_read_ahead
+   * first, and can be enabled again on the new stream. This stream
+   * must not be used afterwards, except for being destroyed or
+   * assigned to.
+   *
+   * @param next_layer The next layer of the new stream.
+   *
+   * @returns A stream with the TLS state of this stream.
+   *
+   * @throws wintls::system_error Thrown with `net::error::in_progress`
+   * if a read ahead is outstanding.
+   */
+  template <class NewNextLayer>
+  stream<typename std::decay<NewNextLayer>::type> release_and_rebind(NewNextLayer&& next_layer) {
+    const auto ec = sspi_stream_->take_read_ahead();
+    if (ec) {
+      detail::throw_error(ec);
+    }
+    stream<typename std::decay<NewNextLayer>::type> rebound{std::forward<NewNextLayer>(next_layer), std::move(sspi_stream_)};
+    if (rebound.sspi_stream_->read_ahead) {
+      rebound.sspi_stream_->read_ahead->set_executor(rebound.next_layer_.get_executor());
+    }
+    return rebound;
   }
 
   /** Get the executor associated with the object.
@@ -128,6 +225,172 @@ public:
     sspi_stream_->handshake.set_certificate_revocation_check(check);
   }
 
+  /** Limit the rate of data written to the stream.
+   *
+   * Shapes the egress of the stream using a token bucket refilled at
+   * the given rate. Records are sized to the available budget and
+   * writing an encrypted record is deferred until enough tokens are
+   * available, so the write operations themselves take longer
+   * instead of data being buffered. The budget is accounted for in
+   * bytes written to the next layer, including the TLS record header
+   * and trailer.
+   *
+   * Does not apply to handshake and shutdown messages.
+   *
+   * @param bytes_per_second The rate to limit writes to, or zero to
+   * remove the limit.
+   * @param burst The number of bytes which can be written at once
+   * after the stream has been idle. Should be at least the size of a
+   * TLS record, around 16 KB, for full sized records to be sent.
+   */
+  void set_write_rate_limit(std::size_t bytes_per_second, std::size_t burst) {
+    if (bytes_per_second == 0) {
+      sspi_stream_->encrypt.rate_limit.reset();
+      return;
+    }
+    sspi_stream_->encrypt.rate_limit = std::make_unique<detail::token_bucket>(bytes_per_second, burst);
+  }
+
+  /** Read ahead from the next layer between asynchronous reads.
+   *
+   * When enabled, a read from the next layer is started whenever an
+   * asynchronous read operation completes, so data keeps arriving
+   * while the application processes the data it was given. The next
+   * read operation continues with the data read ahead instead of
+   * waiting for a new read from the next layer. This keeps the
+   * connection busy for bulk transfers, at the cost of a buffer of
+   * the given size per stream.
+   *
+   * A read of the next layer may be outstanding when no read
+   * operation is, so synchronous reads, @ref export_session and @ref
+   * release_and_rebind fail with `net::error::in_progress` until read
+   * ahead has been stopped using @ref async_stop_read_ahead. The read
+   * ahead completes on the associated executor of the read operation
+   * that started it, so a stream used through a strand stays
+   * serialized.
+   *
+   * @param max_size The maximum number of bytes to read ahead, or
+   * zero to stop reading ahead. Around the size of a few TLS records
+   * is usually enough to keep the connection busy.
+   */
+  void set_read_ahead(std::size_t max_size) {
+    if (!sspi_stream_->read_ahead) {
+      if (max_size == 0) {
+        return;
+      }
+      sspi_stream_->read_ahead = std::make_shared<detail::read_ahead>(next_layer_.get_executor(), max_size);
+      return;
+    }
+    sspi_stream_->read_ahead->set_max_size(max_size);
+  }
+
+  /** Stop reading ahead from the next layer.
+   *
+   * Disables read ahead and waits for a read ahead still outstanding
+   * to complete. Any data it reads is handed out by the following
+   * read operations, or included by @ref export_session and @ref
+   * release_and_rebind. To not wait for the peer to send more data,
+   * the outstanding read can be cancelled by cancelling the next
+   * layer, which isn't treated as an error after stopping.
+   *
+   * @param handler The handler to be called when read ahead has been
+   * stopped. The equivalent function signature of the handler must
+   * be:
+   * @code void handler(
+   *     const wintls::error_code& error // Always success.
+   * );
+   * @endcode
+   */
+  template <class CompletionToken>
+  auto async_stop_read_ahead(CompletionToken&& handler) {
+    return net::async_compose<CompletionToken, void(wintls::error_code)>(
+        detail::async_stop_read_ahead{sspi_stream_->read_ahead.get()}, handler, next_layer_);
+  }
+
+  /** Size reads from the next layer after the observed traffic.
+   *
+   * By default all free buffer space, up to 64 KB, is offered to each
+   * read from the next layer. With adaptive read sizing, reads are
+   * sized after the TLS records received so far, and grow while they
+   * keep filling the space offered as happens for bulk transfers. This
+   * keeps reads small for interactive connections sending small
+   * records while bulk transfers still use few large reads. Reads
+   * always ask for at least the rest of a partially received record.
+   *
+   * Use @ref read_stats to verify how the connection is read.
+   *
+   * @param adaptive Whether to use adaptive read sizing.
+   */
+  void set_adaptive_read_size(bool adaptive) {
+    sspi_stream_->decrypt.read_size.set_adaptive(adaptive);
+  }
+
+  /** Get statistics about the reads from the next layer.
+   *
+   * Counts the reads after the handshake.
+   *
+   * Must not be called concurrently with read operations.
+   */
+  read_statistics read_stats() const {
+    return sspi_stream_->decrypt.read_size.stats();
+  }
+
+  /** Get the number of decrypted bytes not yet read.
+   *
+   * Data decrypted from a TLS record which didn't fit in the buffers
+   * of a read operation, and is returned by the next read.
+   *
+   * May be called from any thread.
+   */
+  std::size_t pending_plaintext() const {
+    return sspi_stream_->pending.plaintext();
+  }
+
+  /** Get the number of received bytes not yet decrypted.
+   *
+   * Data read from the next layer which doesn't form a complete TLS
+   * record yet, or following the record most recently decrypted.
+   *
+   * May be called from any thread.
+   */
+  std::size_t pending_ciphertext_in() const {
+    return sspi_stream_->pending.ciphertext_in();
+  }
+
+  /** Get the number of encrypted bytes queued for the next layer.
+   *
+   * The size of the TLS record being written to the next layer by an
+   * outstanding write operation, zero if none.
+   *
+   * May be called from any thread.
+   */
+  std::size_t pending_ciphertext_out() const {
+    return sspi_stream_->pending.ciphertext_out();
+  }
+
+  /** Set water marks for the number of bytes buffered by the stream.
+   *
+   * The handler is called with `true` when the sum of @ref
+   * pending_plaintext, @ref pending_ciphertext_in and @ref
+   * pending_ciphertext_out reaches the high water mark, and with
+   * `false` when it has dropped to the low water mark again. This
+   * can be used for pausing reading from a producer feeding the
+   * stream until the buffered data has been consumed.
+   *
+   * The handler is called from within the read and write operations
+   * of the stream, possibly from different threads if the stream has
+   * been split, but never concurrently. It must not call this
+   * function.
+   *
+   * @param low The low water mark.
+   * @param high The high water mark.
+   * @param handler The handler to call, or an empty function to stop
+   * notifying.
+   */
+  void set_buffer_watermarks(std::size_t low, std::size_t high, std::function<void(bool)> handler) {
+    sspi_stream_->pending.set_watermarks(low, high, std::move(handler));
+  }
+
   /** Perform TLS handshaking.
    *
    * This function is used to perform TLS handshaking on the
@@ -139,50 +402,7 @@ public:
    * @param ec Set to indicate what error occurred, if any.
    */
   void handshake(handshake_type type, wintls::error_code& ec) {
-    sspi_stream_->handshake(type);
-
-    detail::sspi_handshake::state state;
-    while((state = sspi_stream_->handshake()) != detail::sspi_handshake::state::done) {
-      switch (state) {
-        case detail::sspi_handshake::state::data_needed: {
-          std::size_t size_read = next_layer_.read_some(sspi_stream_->handshake.in_buffer(), ec);
-          if (ec) {
-            return;
-          }
-          sspi_stream_->handshake.size_read(size_read);
-          continue;
-        }
-        case detail::sspi_handshake::state::data_available: {
-          std::size_t size_written = net::write(next_layer_, sspi_stream_->handshake.out_buffer(), ec);
-          if (ec) {
-            return;
-          }
-          sspi_stream_->handshake.size_written(size_written);
-          continue;
-        }
-        case detail::sspi_handshake::state::error:
-          ec = sspi_stream_->handshake.last_error();
-          return;
-        case detail::sspi_handshake::state::done_with_data:{
-          std::size_t size_written = net::write(next_layer_, sspi_stream_->handshake.out_buffer(), ec);
-          if (ec) {
-            return;
-          }
-          sspi_stream_->handshake.size_written(size_written);
-          return;
-        }
-        case detail::sspi_handshake::state::error_with_data:{
-          std::size_t size_written = net::write(next_layer_, sspi_stream_->handshake.out_buffer(), ec);
-          if (ec) {
-            return;
-          }
-          sspi_stream_->handshake.size_written(size_written);
-          return;
-        }
-        case detail::sspi_handshake::state::done:
-          WINTLS_UNREACHABLE_RETURN(0);
-      }
-    }
+    handshake_until(type, detail::no_deadline{}, ec);
   }
 
   /** Perform TLS handshaking.
@@ -204,6 +424,146 @@ public:
     }
   }
 
+  /** Perform TLS handshaking with a deadline.
+   *
+   * This function is used to perform TLS handshaking on the stream
+   * like @ref handshake, but fails with `net::error::timed_out` if
+   * the handshake isn't complete by the deadline, so a stalled peer
+   * doesn't block the calling thread forever. Useful for servers
+   * using a thread per connection.
+   *
+   * The next layer must be a socket or a stream on top of one, like
+   * `beast::tcp_stream`. The socket is waited on using `WSAPoll`
+   * before reading and written to in non-blocking mode. If the
+   * handshake times out, the stream must be closed.
+   *
+   * @param type The @ref handshake_type to be performed, i.e. client
+   * or server.
+   * @param deadline The time at which to give up.
+   * @param ec Set to indicate what error occurred, if any.
+   */
+  void handshake(handshake_type type, std::chrono::steady_clock::time_point deadline, wintls::error_code& ec) {
+    handshake_until(type, deadline, ec);
+  }
+
+  /** Perform TLS handshaking with a deadline.
+   *
+   * This function is used to perform TLS handshaking on the stream
+   * like @ref handshake, but fails if the handshake isn't complete by
+   * the deadline. If the handshake times out, the stream must be
+   * closed.
+   *
+   * @param type The @ref handshake_type to be performed, i.e. client
+   * or server.
+   * @param deadline The time at which to give up.
+   *
+   * @throws wintls::system_error Thrown on failure, with
+   * `net::error::timed_out` if the deadline was reached.
+   */
+  void handshake(handshake_type type, std::chrono::steady_clock::time_point deadline) {
+    wintls::error_code ec{};
+    handshake(type, deadline, ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+  }
+
+  /** Export the established TLS session.
+   *
+   * Serializes the security context together with any data received
+   * from the peer but not yet read, so the session can be continued
+   * by a stream in another process using @ref import_session. Used
+   * with a duplicated socket this allows handing a live connection
+   * from a process terminating the TLS handshake to a worker process,
+   * or keeping connections alive across restarts.
+   *
+   * No operations must be outstanding on the stream and it must not
+   * be used for anything but being destroyed afterwards, as the
+   * exported and the original security context would otherwise get
+   * out of sync. If read ahead is used, it must be stopped using @ref
+   * async_stop_read_ahead first, or this fails with
+   * `net::error::in_progress`.
+   *
+   * @param ec Set to indicate what error occurred, if any.
+   *
+   * @returns The serialized session.
+   *
+   * @note The serialized session contains the session keys and must
+   * be protected accordingly.
+   */
+  std::vector<char> export_session(wintls::error_code& ec) {
+    // Include data read ahead with the data received but not yet read
+    ec = sspi_stream_->take_read_ahead();
+    if (ec) {
+      return {};
+    }
+    std::vector<char> session;
+    const SECURITY_STATUS sc = sspi_stream_->export_session(session);
+    if (sc != SEC_E_OK) {
+      ec = error::make_error_code(sc);
+      return {};
+    }
+    return session;
+  }
+
+  /** Export the established TLS session.
+   *
+   * Serializes the security context together with any data received
+   * from the peer but not yet read, so the session can be continued
+   * by a stream in another process using @ref import_session.
+   *
+   * No operations must be outstanding on the stream and it must not
+   * be used for anything but being destroyed afterwards.
+   *
+   * @returns The serialized session.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   */
+  std::vector<char> export_session() {
+    wintls::error_code ec{};
+    auto session = export_session(ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+    return session;
+  }
+
+  /** Import a TLS session.
+   *
+   * Continues a session exported using @ref export_session instead
+   * of performing a handshake. The next layer must be connected to
+   * the same peer as the stream the session was exported from.
+   *
+   * The stream must be newly constructed, with a @ref context
+   * configured the same way as the one used by the exporting stream.
+   *
+   * @param session The serialized session.
+   * @param ec Set to indicate what error occurred, if any.
+   */
+  void import_session(const net::const_buffer& session, wintls::error_code& ec) {
+    const SECURITY_STATUS sc = sspi_stream_->import_session(session);
+    if (sc != SEC_E_OK) {
+      ec = error::make_error_code(sc);
+    }
+  }
+
+  /** Import a TLS session.
+   *
+   * Continues a session exported using @ref export_session instead
+   * of performing a handshake.
+   *
+   * @param session The serialized session.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   */
+  void import_session(const net::const_buffer& session) {
+    wintls::error_code ec{};
+    import_session(session, ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+  }
+
   /** Start an asynchronous TLS handshake.
    *
    * This function is used to asynchronously perform an TLS
@@ -251,22 +611,7 @@ public:
    */
   template <class MutableBufferSequence>
   size_t read_some(const MutableBufferSequence& buffers, wintls::error_code& ec) {
-    detail::sspi_decrypt::state state;
-    while((state = sspi_stream_->decrypt(buffers)) == detail::sspi_decrypt::state::data_needed) {
-      std::size_t size_read = next_layer_.read_some(sspi_stream_->decrypt.input_buffer, ec);
-      if (ec) {
-        return 0;
-      }
-      sspi_stream_->decrypt.size_read(size_read);
-      continue;
-    }
-
-    if (state == detail::sspi_decrypt::state::error) {
-      ec = sspi_stream_->decrypt.last_error();
-      return 0;
-    }
-
-    return sspi_stream_->decrypt.size_decrypted;
+    return read_some_until(buffers, detail::no_deadline{}, ec);
   }
 
   /** Read some data from the stream.
@@ -296,6 +641,52 @@ public:
     return read;
   }
 
+  /** Read some data from the stream with a deadline.
+   *
+   * This function is used to read data from the stream like @ref
+   * read_some, but fails with `net::error::timed_out` if no data has
+   * been received by the deadline. Data already received is returned
+   * right away. A timed out read can be retried, as no data is lost.
+   *
+   * The next layer must be a socket or a stream on top of one, like
+   * `beast::tcp_stream`. The socket is waited on using `WSAPoll`
+   * before reading.
+   *
+   * @param buffers The buffers into which the data will be read.
+   * @param deadline The time at which to give up.
+   * @param ec Set to indicate what error occurred, if any.
+   *
+   * @returns The number of bytes read.
+   */
+  template <class MutableBufferSequence>
+  size_t read_some(const MutableBufferSequence& buffers, std::chrono::steady_clock::time_point deadline, wintls::error_code& ec) {
+    return read_some_until(buffers, deadline, ec);
+  }
+
+  /** Read some data from the stream with a deadline.
+   *
+   * This function is used to read data from the stream like @ref
+   * read_some, but fails if no data has been received by the
+   * deadline.
+   *
+   * @param buffers The buffers into which the data will be read.
+   * @param deadline The time at which to give up.
+   *
+   * @returns The number of bytes read.
+   *
+   * @throws wintls::system_error Thrown on failure, with
+   * `net::error::timed_out` if the deadline was reached.
+   */
+  template <class MutableBufferSequence>
+  size_t read_some(const MutableBufferSequence& buffers, std::chrono::steady_clock::time_point deadline) {
+    wintls::error_code ec{};
+    auto read = read_some(buffers, deadline, ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+    return read;
+  }
+
   /** Start an asynchronous read.
    *
    * This function is used to asynchronously read one or more bytes of
@@ -324,7 +715,8 @@ public:
   template <class MutableBufferSequence, class CompletionToken>
   auto async_read_some(const MutableBufferSequence& buffers, CompletionToken&& handler) {
     return net::async_compose<CompletionToken, void(wintls::error_code, std::size_t)>(
-        detail::async_read<next_layer_type, MutableBufferSequence>{next_layer_, buffers, sspi_stream_->decrypt}, handler);
+        detail::async_read<next_layer_type, MutableBufferSequence>{
+          next_layer_, buffers, sspi_stream_->decrypt, sspi_stream_->read_ahead.get()}, handler);
   }
 
   /** Write some data to the stream.
@@ -345,17 +737,7 @@ public:
    */
   template <class ConstBufferSequence>
   std::size_t write_some(const ConstBufferSequence& buffers, wintls::error_code& ec) {
-    std::size_t bytes_consumed = sspi_stream_->encrypt(buffers, ec);
-    if (ec) {
-      return 0;
-    }
-
-    net::write(next_layer_, sspi_stream_->encrypt.buffers, ec);
-    if (ec) {
-      return 0;
-    }
-
-    return bytes_consumed;
+    return write_some_until(buffers, detail::no_deadline{}, ec);
   }
 
   /** Write some data to the stream.
@@ -385,6 +767,53 @@ public:
     return wrote;
   }
 
+  /** Write some data to the stream with a deadline.
+   *
+   * This function is used to write data on the stream like @ref
+   * write_some, but fails with `net::error::timed_out` if the
+   * encrypted data hasn't been written to the next layer by the
+   * deadline, for instance because the peer isn't reading.
+   *
+   * The next layer must be a socket or a stream on top of one, like
+   * `beast::tcp_stream`. The socket is written to in non-blocking
+   * mode while waiting using `WSAPoll`.
+   * If the write times out, part of a TLS record may have been sent
+   * and the stream must be closed.
+   *
+   * @param buffers The data to be written.
+   * @param deadline The time at which to give up.
+   * @param ec Set to indicate what error occurred, if any.
+   *
+   * @returns The number of bytes written.
+   */
+  template <class ConstBufferSequence>
+  std::size_t write_some(const ConstBufferSequence& buffers, std::chrono::steady_clock::time_point deadline, wintls::error_code& ec) {
+    return write_some_until(buffers, deadline, ec);
+  }
+
+  /** Write some data to the stream with a deadline.
+   *
+   * This function is used to write data on the stream like @ref
+   * write_some, but fails if the data hasn't been written by the
+   * deadline. If the write times out, the stream must be closed.
+   *
+   * @param buffers The data to be written.
+   * @param deadline The time at which to give up.
+   *
+   * @returns The number of bytes written.
+   *
+   * @throws wintls::system_error Thrown on failure, with
+   * `net::error::timed_out` if the deadline was reached.
+   */
+  template <class ConstBufferSequence>
+  std::size_t write_some(const ConstBufferSequence& buffers, std::chrono::steady_clock::time_point deadline) {
+    wintls::error_code ec{};
+    auto wrote = write_some(buffers, deadline, ec);
+    if (ec) {
+      detail::throw_error(ec);
+    }
+    return wrote;
+  }
 
   /** Start an asynchronous write.
    *
@@ -472,11 +901,403 @@ public:
         detail::async_shutdown<next_layer_type>{next_layer_, sspi_stream_->shutdown}, handler);
   }
 
+  /** Close the stream abortively.
+   *
+   * Frees the security context and the buffers of the stream right
+   * away without sending a TLS close_notify alert to the peer or
+   * waiting for one. Useful for short-lived connections where the
+   * application protocol already delimits the messages, making the
+   * teardown of a connection almost free. The peer sees the
+   * connection closed without a close_notify alert, which it may
+   * treat as a truncation attack if it relies on it.
+   *
+   * The next layer isn't closed, which should be done by the caller.
+   * No operations must be outstanding on the stream, and it must not
+   * be used for anything but accessing the next layer and being
+   * destroyed afterwards.
+   *
+   * Counted separately from graceful shutdowns in the @ref
+   * context::statistics of the context used.
+   */
+  void abort() {
+    if (sspi_stream_) {
+      sspi_stream_->aborted();
+      sspi_stream_.reset();
+    }
+  }
+
+  class read_half;
+  class write_half;
+
+  /** Split the stream into independent read and write halves.
+   *
+   * The halves refer to this stream, which must outlive them, and
+   * exist so the reading and the writing side of a full-duplex
+   * connection can be handed to different parts of a program, like
+   * the two directions of a proxy.
+   *
+   * <b>Thread safety:</b> One operation on the @ref read_half and one
+   * operation on the @ref write_half may be outstanding at the same
+   * time, even when initiated from or completing on different
+   * threads. Schannel supports encrypting and decrypting concurrently
+   * on the same security context and the stream keeps no state shared
+   * between the two directions. The next layer must support a read
+   * and a write being performed concurrently, which is the case for
+   * sockets. Concurrent operations on the same half are not allowed.
+   *
+   * <b>Post-handshake messages:</b> The read half never writes to the
+   * next layer. Handshake messages received after the handshake has
+   * completed, like a renegotiation request from the peer, are not
+   * answered and make the read half fail with the status returned by
+   * Schannel. The write half is unaffected by this.
+   *
+   * The handshake must be completed before splitting the stream.
+   *
+   * @returns The read and write halves of the stream.
+   */
+  std::pair<read_half, write_half> split() {
+    return {read_half{*this}, write_half{*this}};
+  }
+
 private:
+  template <class>
+  friend class stream;
+  template <class>
+  friend class connection_pool;
+  template <class>
+  friend class connection_reservoir;
+  friend struct detail::relay_initiation;
+  friend struct detail::send_file_initiation;
+
+  template <class Arg>
+  stream(Arg&& arg, std::unique_ptr<detail::sspi_stream> sspi_stream)
+    : next_layer_(std::forward<Arg>(arg))
+    , sspi_stream_(std::move(sspi_stream)) {
+    attach();
+  }
+
+  template <class Deadline>
+  void handshake_until(handshake_type type, const Deadline& until, wintls::error_code& ec) {
+    sspi_stream_->handshake(type);
+
+    detail::sspi_handshake::state state;
+    while((state = sspi_stream_->handshake()) != detail::sspi_handshake::state::done) {
+      switch (state) {
+        case detail::sspi_handshake::state::data_needed: {
+          std::size_t size_read = detail::sync_read_some(next_layer_, sspi_stream_->handshake.in_buffer(), until, ec);
+          if (ec) {
+            return;
+          }
+          sspi_stream_->handshake.size_read(size_read);
+          continue;
+        }
+        case detail::sspi_handshake::state::data_available: {
+          std::size_t size_written = detail::sync_write(next_layer_, sspi_stream_->handshake.out_buffer(), until, ec);
+          if (ec) {
+            return;
+          }
+          sspi_stream_->handshake.size_written(size_written);
+          continue;
+        }
+        case detail::sspi_handshake::state::error:
+          ec = sspi_stream_->handshake.last_error();
+          return;
+        case detail::sspi_handshake::state::done_with_data:{
+          std::size_t size_written = detail::sync_write(next_layer_, sspi_stream_->handshake.out_buffer(), until, ec);
+          if (ec) {
+            return;
+          }
+          sspi_stream_->handshake.size_written(size_written);
+          return;
+        }
+        case detail::sspi_handshake::state::error_with_data:{
+          std::size_t size_written = detail::sync_write(next_layer_, sspi_stream_->handshake.out_buffer(), until, ec);
+          if (ec) {
+            return;
+          }
+          sspi_stream_->handshake.size_written(size_written);
+          return;
+        }
+        case detail::sspi_handshake::state::done:
+          WINTLS_UNREACHABLE_RETURN(0);
+      }
+    }
+  }
+
+  template <class MutableBufferSequence, class Deadline>
+  size_t read_some_until(const MutableBufferSequence& buffers, const Deadline& until, wintls::error_code& ec) {
+    detail::sspi_decrypt::state state;
+    while((state = sspi_stream_->decrypt(buffers)) == detail::sspi_decrypt::state::data_needed) {
+      if (sspi_stream_->read_ahead && sspi_stream_->read_ahead->in_progress()) {
+        ec = net::error::in_progress;
+        return 0;
+      }
+      if (sspi_stream_->read_ahead && sspi_stream_->read_ahead->completed()) {
+        const auto size = sspi_stream_->read_ahead->take(sspi_stream_->decrypt.input_buffer, ec);
+        if (ec) {
+          return 0;
+        }
+        sspi_stream_->decrypt.size_read(size);
+        continue;
+      }
+      std::size_t size_read = detail::sync_read_some(next_layer_, sspi_stream_->decrypt.input_buffer, until, ec);
+      if (ec) {
+        return 0;
+      }
+      sspi_stream_->decrypt.size_read(size_read);
+      continue;
+    }
+
+    if (state == detail::sspi_decrypt::state::error) {
+      ec = sspi_stream_->decrypt.last_error();
+      return 0;
+    }
+
+    return sspi_stream_->decrypt.size_decrypted;
+  }
+
+  template <class ConstBufferSequence, class Deadline>
+  std::size_t write_some_until(const ConstBufferSequence& buffers, const Deadline& until, wintls::error_code& ec) {
+    const auto delay = sspi_stream_->encrypt.write_delay(net::buffer_size(buffers), ec);
+    if (ec) {
+      return 0;
+    }
+    if (delay != delay.zero()) {
+      detail::sync_sleep_for(delay, until, ec);
+      if (ec) {
+        return 0;
+      }
+    }
+
+    std::size_t bytes_consumed = sspi_stream_->encrypt(buffers, ec);
+    if (ec) {
+      return 0;
+    }
+
+    detail::sync_write(next_layer_, sspi_stream_->encrypt.output(), until, ec);
+    sspi_stream_->encrypt.size_written();
+    if (ec) {
+      return 0;
+    }
+
+    return bytes_consumed;
+  }
+
+  // Register this stream as the owner of the TLS state with the
+  // context, so it can be shut down by context::async_drain
+  void attach() {
+    if (!sspi_stream_) {
+      return;
+    }
+    sspi_stream_->attach(this, &stream::drain_post, &stream::drain_shutdown, &stream::drain_close);
+  }
+
+  static void drain_post(void* owner, std::function<void()> function) {
+    net::post(static_cast<stream*>(owner)->next_layer_.get_executor(), std::move(function));
+  }
+
+  static void drain_shutdown(void* owner, std::function<void(const wintls::error_code&)> done) {
+    static_cast<stream*>(owner)->async_shutdown(std::move(done));
+  }
+
+  static void drain_close(void* owner) {
+    static_cast<stream*>(owner)->close_next_layer(0);
+  }
+
+  // Close the next layer if it can be closed, preferring the non
+  // throwing overload
+  template <class T = next_layer_type>
+  auto close_next_layer(int) -> decltype(std::declval<T&>().close(std::declval<wintls::error_code&>()), void()) {
+    wintls::error_code ec{};
+    next_layer_.close(ec);
+  }
+
+  template <class T = next_layer_type>
+  auto close_next_layer(long) -> decltype(std::declval<T&>().close(), void()) {
+    next_layer_.close();
+  }
+
+  void close_next_layer(...) {
+  }
+
   NextLayer next_layer_;
   std::unique_ptr<detail::sspi_stream> sspi_stream_;
 };
 
+/** The reading half of a @ref stream.
+ *
+ * Obtained using @ref stream::split.
+ */
+template <class NextLayer>
+class stream<NextLayer>::read_half {
+public:
+  /// Get the executor associated with the stream.
+  executor_type get_executor() {
+    return stream_->get_executor();
+  }
+
+  /** Read some data from the stream.
+   *
+   * Same as @ref stream::read_some.
+   *
+   * @param buffers The buffers into which the data will be read.
+   * @param ec Set to indicate what error occurred, if any.
+   *
+   * @returns The number of bytes read.
+   */
+  template <class MutableBufferSequence>
+  std::size_t read_some(const MutableBufferSequence& buffers, wintls::error_code& ec) {
+    return stream_->read_some(buffers, ec);
+  }
+
+  /** Read some data from the stream.
+   *
+   * Same as @ref stream::read_some.
+   *
+   * @param buffers The buffers into which the data will be read.
+   *
+   * @returns The number of bytes read.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   */
+  template <class MutableBufferSequence>
+  std::size_t read_some(const MutableBufferSequence& buffers) {
+    return stream_->read_some(buffers);
+  }
+
+  /** Start an asynchronous read.
+   *
+   * Same as @ref stream::async_read_some.
+   *
+   * @param buffers The buffers into which the data will be read.
+   * @param handler The handler to be called when the read operation
+   * completes.
+   */
+  template <class MutableBufferSequence, class CompletionToken>
+  auto async_read_some(const MutableBufferSequence& buffers, CompletionToken&& handler) {
+    return stream_->async_read_some(buffers, std::forward<CompletionToken>(handler));
+  }
+
+private:
+  friend class stream;
+
+  explicit read_half(stream& s)
+    : stream_(&s) {
+  }
+
+  stream* stream_;
+};
+
+/** The writing half of a @ref stream.
+ *
+ * Obtained using @ref stream::split.
+ */
+template <class NextLayer>
+class stream<NextLayer>::write_half {
+public:
+  /// Get the executor associated with the stream.
+  executor_type get_executor() {
+    return stream_->get_executor();
+  }
+
+  /** Write some data to the stream.
+   *
+   * Same as @ref stream::write_some.
+   *
+   * @param buffers The data to be written.
+   * @param ec Set to indicate what error occurred, if any.
+   *
+   * @returns The number of bytes written.
+   */
+  template <class ConstBufferSequence>
+  std::size_t write_some(const ConstBufferSequence& buffers, wintls::error_code& ec) {
+    return stream_->write_some(buffers, ec);
+  }
+
+  /** Write some data to the stream.
+   *
+   * Same as @ref stream::write_some.
+   *
+   * @param buffers The data to be written.
+   *
+   * @returns The number of bytes written.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   */
+  template <class ConstBufferSequence>
+  std::size_t write_some(const ConstBufferSequence& buffers) {
+    return stream_->write_some(buffers);
+  }
+
+  /** Start an asynchronous write.
+   *
+   * Same as @ref stream::async_write_some.
+   *
+   * @param buffers The data to be written to the stream.
+   * @param handler The handler to be called when the write operation
+   * completes.
+   */
+  template <class ConstBufferSequence, class CompletionToken>
+  auto async_write_some(const ConstBufferSequence& buffers, CompletionToken&& handler) {
+    return stream_->async_write_some(buffers, std::forward<CompletionToken>(handler));
+  }
+
+  /** Shut down TLS on the stream.
+   *
+   * Same as @ref stream::shutdown. Sends a TLS close_notify alert to
+   * the peer.
+   *
+   * @param ec Set to indicate what error occurred, if any.
+   *
+   * @note Shutting down updates the security context and must not be
+   * done while a read is outstanding on the @ref read_half.
+   */
+  void shutdown(wintls::error_code& ec) {
+    stream_->shutdown(ec);
+  }
+
+  /** Shut down TLS on the stream.
+   *
+   * Same as @ref stream::shutdown.
+   *
+   * @throws wintls::system_error Thrown on failure.
+   *
+   * @note Shutting down updates the security context and must not be
+   * done while a read is outstanding on the @ref read_half.
+   */
+  void shutdown() {
+    stream_->shutdown();
+  }
+
+  /** Asynchronously shut down TLS on the stream.
+   *
+   * Same as @ref stream::async_shutdown.
+   *
+   * @param handler The handler to be called when the shutdown
+   * operation completes.
+   *
+   * @note Shutting down updates the security context and must not be
+   * done while a read is outstanding on the @ref read_half.
+   */
+  template <class CompletionToken>
+  auto async_shutdown(CompletionToken&& handler) {
+    return stream_->async_shutdown(std::forward<CompletionToken>(handler));
+  }
+
+private:
+  friend class stream;
+
+  explicit write_half(stream& s)
+    : stream_(&s) {
+  }
+
+  stream* stream_;
+};
+
+#if !WINTLS_HEADER_ONLY
+extern template class stream<net::ip::tcp::socket>;
+#endif // !WINTLS_HEADER_ONLY
+
 } // namespace wintls
 
 #endif // WINTLS_STREAM_HPP
@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "unittest.hpp"
+#include "wintls_client_stream.hpp"
+#include "wintls_server_stream.hpp"
+
+#include <wintls.hpp>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using tcp = net::ip::tcp;
+
+// An endpoint on the loopback interface nobody is listening on
+tcp::endpoint unused_endpoint(net::io_context& ioc) {
+  tcp::acceptor acceptor{ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}};
+  return acceptor.local_endpoint();
+}
+
+// A socket where connecting to port 1 fails when the given delay
+// has passed and connecting to any other port succeeds right away
+class delayed_failure_socket {
+public:
+  using endpoint_type = tcp::endpoint;
+  using executor_type = net::io_context::executor_type;
+
+  explicit delayed_failure_socket(const executor_type& executor)
+    : timer_(executor) {
+  }
+
+  static std::chrono::steady_clock::duration& failure_delay() {
+    static std::chrono::steady_clock::duration delay{};
+    return delay;
+  }
+
+  template <class Handler>
+  void async_connect(const endpoint_type& endpoint, Handler&& handler) {
+    if (endpoint.port() != 1) {
+      net::post(timer_.get_executor(), [handler = std::forward<Handler>(handler)]() mutable {
+        handler(error_code{});
+      });
+      return;
+    }
+    timer_.expires_after(failure_delay());
+    timer_.async_wait([handler = std::forward<Handler>(handler)](const error_code&) mutable {
+      handler(error_code{net::error::connection_refused});
+    });
+  }
+
+  void close(error_code&) {
+    timer_.cancel();
+  }
+
+private:
+  net::steady_timer timer_;
+};
+
+} // namespace
+
+TEST_CASE("interleave address families") {
+  const tcp::endpoint a6{net::ip::make_address("::1"), 1};
+  const tcp::endpoint b6{net::ip::make_address("::1"), 2};
+  const tcp::endpoint c6{net::ip::make_address("::1"), 3};
+  const tcp::endpoint a4{net::ip::make_address("127.0.0.1"), 1};
+  const tcp::endpoint b4{net::ip::make_address("127.0.0.1"), 2};
+
+  using endpoint_list = std::vector<tcp::endpoint>;
+  CHECK(wintls::detail::interleave_address_families(endpoint_list{}).empty());
+  CHECK(wintls::detail::interleave_address_families(endpoint_list{a6, b6, c6, a4, b4}) ==
+        endpoint_list{a6, a4, b6, b4, c6});
+  CHECK(wintls::detail::interleave_address_families(endpoint_list{a4, b4, a6}) ==
+        endpoint_list{a4, a6, b4});
+}
+
+TEST_CASE("async_connect_and_handshake") {
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+
+  tcp::acceptor acceptor{ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}};
+  std::unique_ptr<wintls::stream<tcp::socket>> server;
+  acceptor.async_accept([&](const error_code& ec, tcp::socket socket) {
+    REQUIRE_FALSE(ec);
+    server = std::make_unique<wintls::stream<tcp::socket>>(std::move(socket), server_ctx);
+    server->async_handshake(wintls::handshake_type::server, [](const error_code&) {});
+  });
+
+  wintls::stream<tcp::socket> client{ioc, client_ctx};
+  client.set_server_hostname("localhost");
+
+  SECTION("first endpoint unreachable") {
+    const std::vector<tcp::endpoint> endpoints{unused_endpoint(ioc), acceptor.local_endpoint()};
+    error_code client_ec{net::error::would_block};
+    tcp::endpoint winner;
+    wintls::async_connect_and_handshake(client, endpoints, std::chrono::milliseconds(10),
+                                        [&](const error_code& ec, const tcp::endpoint& endpoint) {
+      client_ec = ec;
+      winner = endpoint;
+    });
+    ioc.run();
+    REQUIRE_FALSE(client_ec);
+    CHECK(winner == acceptor.local_endpoint());
+    CHECK(client.next_layer().remote_endpoint() == acceptor.local_endpoint());
+  }
+
+  SECTION("no endpoints") {
+    error_code client_ec{};
+    wintls::async_connect_and_handshake(client, std::vector<tcp::endpoint>{},
+                                        [&](const error_code& ec, const tcp::endpoint&) {
+      client_ec = ec;
+    });
+    acceptor.close();
+    ioc.run();
+    CHECK(client_ec == net::error::host_not_found);
+  }
+
+  SECTION("all endpoints unreachable") {
+    const std::vector<tcp::endpoint> endpoints{unused_endpoint(ioc), unused_endpoint(ioc)};
+    error_code client_ec{};
+    tcp::endpoint winner{net::ip::make_address("127.0.0.1"), 1};
+    wintls::async_connect_and_handshake(client, endpoints, std::chrono::milliseconds(10),
+                                        [&](const error_code& ec, const tcp::endpoint& endpoint) {
+      client_ec = ec;
+      winner = endpoint;
+    });
+    acceptor.close();
+    ioc.run();
+    CHECK(client_ec);
+    CHECK(winner == tcp::endpoint{});
+  }
+}
+
+TEST_CASE("attempt failing as the attempt delay expires") {
+  net::io_context ioc;
+  const auto delay = std::chrono::milliseconds(10);
+  delayed_failure_socket::failure_delay() = delay;
+
+  const tcp::endpoint failing{net::ip::make_address("127.0.0.1"), 1};
+  const tcp::endpoint working{net::ip::make_address("127.0.0.1"), 2};
+  error_code race_ec{net::error::would_block};
+  tcp::endpoint winner;
+  wintls::detail::start_happy_eyeballs_race<delayed_failure_socket>(
+    ioc.get_executor(), std::vector<tcp::endpoint>{failing, working}, delay,
+    [&](const error_code& ec, delayed_failure_socket, const tcp::endpoint& endpoint) {
+      race_ec = ec;
+      winner = endpoint;
+    });
+
+  // Start the first attempt, then let both the failure and the attempt
+  // delay expire before running the handlers, so the wait has already
+  // completed when the failure starts the last attempt
+  ioc.poll();
+  std::this_thread::sleep_for(delay * 3);
+  ioc.run();
+
+  CHECK_FALSE(race_ec);
+  CHECK(winner == working);
+}
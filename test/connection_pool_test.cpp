@@ -0,0 +1,299 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "unittest.hpp"
+#include "wintls_client_stream.hpp"
+#include "wintls_server_stream.hpp"
+#include "stream_handshake.hpp"
+
+#include <wintls.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using pool_type = wintls::connection_pool<test_stream>;
+
+struct pooled_pair {
+  pooled_pair(net::io_context& ioc, wintls::context& client_ctx, wintls::context& server_ctx)
+    : client(std::make_unique<wintls::stream<test_stream>>(ioc, client_ctx))
+    , server(ioc, server_ctx) {
+    client->next_layer().connect(server.next_layer());
+  }
+
+  void handshake(net::io_context& ioc) {
+    handshake_pair(ioc, *client, server);
+  }
+
+  pool_type::stream_ptr client;
+  wintls::stream<test_stream> server;
+};
+
+} // namespace
+
+TEST_CASE("connection pool") {
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+  const wintls::connection_pool_key key{"localhost", "443", "localhost", &client_ctx};
+  pool_type pool{2};
+
+  SECTION("empty pool") {
+    CHECK_FALSE(pool.try_acquire(key));
+    CHECK(pool.idle_count(key) == 0);
+  }
+
+  SECTION("reuse released stream") {
+    pooled_pair pair{ioc, client_ctx, server_ctx};
+    pair.handshake(ioc);
+    auto* client = pair.client.get();
+
+    pool.release(key, std::move(pair.client));
+    CHECK(pool.idle_count(key) == 1);
+
+    // Only handed out for the same key
+    const wintls::connection_pool_key other_key{"localhost", "443", "example.com", &client_ctx};
+    CHECK_FALSE(pool.try_acquire(other_key));
+
+    auto stream = pool.try_acquire(key);
+    CHECK(stream.get() == client);
+    CHECK(pool.idle_count(key) == 0);
+
+    // The stream is still usable
+    const std::string message{"hello"};
+    net::write(*stream, net::buffer(message));
+    std::string received(message.size(), '\0');
+    net::read(pair.server, net::buffer(&received[0], received.size()));
+    CHECK(received == message);
+  }
+
+  SECTION("max idle streams") {
+    pooled_pair first{ioc, client_ctx, server_ctx};
+    pooled_pair second{ioc, client_ctx, server_ctx};
+    pooled_pair third{ioc, client_ctx, server_ctx};
+    first.handshake(ioc);
+    second.handshake(ioc);
+    third.handshake(ioc);
+
+    pool.release(key, std::move(first.client));
+    pool.release(key, std::move(second.client));
+    pool.release(key, std::move(third.client));
+    CHECK(pool.idle_count(key) == 2);
+
+    pool.clear();
+    CHECK(pool.idle_count(key) == 0);
+  }
+
+  SECTION("stream with unread data is discarded") {
+    pooled_pair pair{ioc, client_ctx, server_ctx};
+    pair.handshake(ioc);
+
+    const std::string message{"unread data"};
+    net::write(pair.server, net::buffer(message));
+    char c;
+    CHECK(pair.client->read_some(net::buffer(&c, 1)) == 1);
+
+    pool.release(key, std::move(pair.client));
+    CHECK(pool.idle_count(key) == 0);
+  }
+
+  SECTION("aborted stream is discarded") {
+    pooled_pair pair{ioc, client_ctx, server_ctx};
+    pair.handshake(ioc);
+
+    pair.client->abort();
+    pool.release(key, std::move(pair.client));
+    CHECK(pool.idle_count(key) == 0);
+  }
+
+  SECTION("stream with outstanding read ahead is discarded") {
+    pooled_pair pair{ioc, client_ctx, server_ctx};
+    pair.handshake(ioc);
+    pair.client->set_read_ahead(1000);
+
+    const std::string message{"message"};
+    net::write(pair.server, net::buffer(message));
+    std::string received(message.size(), '\0');
+    bool done = false;
+    net::async_read(*pair.client, net::buffer(&received[0], received.size()),
+                    [&done](const error_code& ec, std::size_t) {
+      REQUIRE_FALSE(ec);
+      done = true;
+    });
+    while (!done) {
+      ioc.run_one();
+    }
+
+    // The read ahead started by the read is still outstanding
+    pool.release(key, std::move(pair.client));
+    CHECK(pool.idle_count(key) == 0);
+  }
+}
+
+TEST_CASE("reuse credentials") {
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+  client_ctx.reuse_credentials(true);
+  server_ctx.reuse_credentials(true);
+
+  // Reconnecting using the same credentials
+  for (int i = 0; i < 3; ++i) {
+    pooled_pair pair{ioc, client_ctx, server_ctx};
+    pair.handshake(ioc);
+  }
+  CHECK(client_ctx.statistics().credentials_acquired == 1);
+  CHECK(server_ctx.statistics().credentials_acquired == 1);
+
+  // New credentials are acquired after changing the certificate
+  auto cert = wintls::x509_to_cert_context(net::buffer(test_certificate), wintls::file_format::pem);
+  wintls::assign_private_key(cert.get(), test_key_name_server);
+  server_ctx.use_certificate(cert.get());
+  pooled_pair pair{ioc, client_ctx, server_ctx};
+  pair.handshake(ioc);
+  CHECK(client_ctx.statistics().credentials_acquired == 1);
+  CHECK(server_ctx.statistics().credentials_acquired == 2);
+
+  // Without reuse, each stream acquires its own credentials
+  wintls_client_context other_client_ctx;
+  for (int i = 0; i < 2; ++i) {
+    pooled_pair other_pair{ioc, other_client_ctx, server_ctx};
+    other_pair.handshake(ioc);
+  }
+  CHECK(other_client_ctx.statistics().credentials_acquired == 2);
+}
+
+TEST_CASE("connection pool over tcp") {
+  using tcp = net::ip::tcp;
+  using tcp_pool_type = wintls::connection_pool<tcp::socket>;
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+
+  tcp::acceptor acceptor{ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}};
+  std::vector<std::unique_ptr<wintls::stream<tcp::socket>>> server_streams;
+  std::function<void()> do_accept = [&]() {
+    acceptor.async_accept([&](const error_code& ec, tcp::socket socket) {
+      if (ec) {
+        return;
+      }
+      server_streams.push_back(std::make_unique<wintls::stream<tcp::socket>>(std::move(socket), server_ctx));
+      server_streams.back()->async_handshake(wintls::handshake_type::server, [](const error_code&) {});
+      do_accept();
+    });
+  };
+  do_accept();
+
+  const wintls::connection_pool_key key{"127.0.0.1", std::to_string(acceptor.local_endpoint().port()), "localhost", &client_ctx};
+  tcp_pool_type pool;
+
+  auto acquire = [&]() {
+    error_code acquire_ec{net::error::would_block};
+    tcp_pool_type::stream_ptr acquired;
+    pool.async_acquire(key, ioc.get_executor(), [&](const error_code& ec, tcp_pool_type::stream_ptr s) {
+      acquire_ec = ec;
+      acquired = std::move(s);
+    });
+    while (acquire_ec == net::error::would_block) {
+      ioc.run_one();
+    }
+    REQUIRE_FALSE(acquire_ec);
+    REQUIRE(acquired);
+    return acquired;
+  };
+
+  auto first = acquire();
+  auto* first_ptr = first.get();
+  REQUIRE(server_streams.size() == 1);
+  pool.release(key, std::move(first));
+  CHECK(pool.idle_count(key) == 1);
+
+  SECTION("idle connection is reused") {
+    auto second = acquire();
+    CHECK(second.get() == first_ptr);
+    CHECK(server_streams.size() == 1);
+  }
+
+  SECTION("idle connection closed by the server is replaced") {
+    server_streams.front()->next_layer().close();
+    // Give the FIN time to arrive on the loopback interface
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // A new connection is made instead
+    auto second = acquire();
+    CHECK(pool.idle_count(key) == 0);
+    CHECK(server_streams.size() == 2);
+
+    const std::string message{"hello"};
+    net::write(*second, net::buffer(message));
+  }
+
+  acceptor.close();
+}
+
+TEST_CASE("connection reservoir") {
+  using tcp = net::ip::tcp;
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+
+  // Server accepting and handshaking any number of connections
+  tcp::acceptor acceptor{ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}};
+  std::vector<std::unique_ptr<wintls::stream<tcp::socket>>> server_streams;
+  std::function<void()> do_accept = [&]() {
+    acceptor.async_accept([&](const error_code& ec, tcp::socket socket) {
+      if (ec) {
+        return;
+      }
+      server_streams.push_back(std::make_unique<wintls::stream<tcp::socket>>(std::move(socket), server_ctx));
+      server_streams.back()->async_handshake(wintls::handshake_type::server, [](const error_code&) {});
+      do_accept();
+    });
+  };
+  do_accept();
+
+  const wintls::connection_pool_key key{"127.0.0.1", std::to_string(acceptor.local_endpoint().port()), "localhost", &client_ctx};
+  wintls::connection_reservoir<tcp::socket> reservoir{ioc.get_executor(), key, 2, std::chrono::minutes(1)};
+
+  auto run_until_available = [&](std::size_t count) {
+    for (int i = 0; i < 500 && reservoir.available() < count; ++i) {
+      ioc.run_one_for(std::chrono::milliseconds(10));
+    }
+  };
+
+  CHECK_FALSE(reservoir.try_pop());
+  reservoir.start();
+  run_until_available(2);
+  REQUIRE(reservoir.available() == 2);
+
+  auto stream = reservoir.try_pop();
+  REQUIRE(stream);
+  CHECK(reservoir.available() == 1);
+
+  // The stream is established and a replacement is made
+  const std::string message{"hello"};
+  net::write(*stream, net::buffer(message));
+  run_until_available(2);
+  CHECK(reservoir.available() == 2);
+  CHECK(server_streams.size() == 3);
+
+  // A spare stream idle for too long is replaced with a new one
+  wintls::connection_reservoir<tcp::socket> short_lived{ioc.get_executor(), key, 1, std::chrono::milliseconds(100)};
+  const auto accepted = server_streams.size();
+  short_lived.start();
+  for (int i = 0; i < 500 && server_streams.size() < accepted + 2; ++i) {
+    ioc.run_one_for(std::chrono::milliseconds(10));
+  }
+  CHECK(server_streams.size() == accepted + 2);
+
+  acceptor.close();
+}
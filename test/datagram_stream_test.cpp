@@ -0,0 +1,251 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "certificate.hpp"
+#include "unittest.hpp"
+
+#include <wintls.hpp>
+
+#include <chrono>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+using udp = net::ip::udp;
+
+const std::string test_key_name_dtls = test_key_name + "-dtls";
+
+struct dtls_server_context : public wintls::context {
+  dtls_server_context()
+    : wintls::context(wintls::method::dtlsv12_server) {
+    error_code dummy;
+    wintls::delete_private_key(test_key_name_dtls, dummy);
+
+    auto cert_ptr = x509_to_cert_context(net::buffer(test_certificate), wintls::file_format::pem);
+    wintls::import_private_key(net::buffer(test_key), wintls::file_format::pem, test_key_name_dtls);
+    wintls::assign_private_key(cert_ptr.get(), test_key_name_dtls);
+    use_certificate(cert_ptr.get());
+  }
+
+  ~dtls_server_context() {
+    wintls::delete_private_key(test_key_name_dtls);
+  }
+};
+
+// A UDP socket on the loopback interface which can be told to lose
+// the next datagrams sent
+class lossy_socket {
+public:
+  using executor_type = udp::socket::executor_type;
+
+  explicit lossy_socket(net::io_context& ioc)
+    : socket_(ioc, udp::endpoint{net::ip::make_address("127.0.0.1"), 0}) {
+  }
+
+  void connect(lossy_socket& other) {
+    socket_.connect(other.socket_.local_endpoint());
+    other.socket_.connect(socket_.local_endpoint());
+  }
+
+  void lose_next(int count) {
+    lose_ = count;
+  }
+
+  executor_type get_executor() {
+    return socket_.get_executor();
+  }
+
+  template <class ConstBufferSequence>
+  std::size_t send(const ConstBufferSequence& buffers, udp::socket::message_flags flags, error_code& ec) {
+    if (lose_ > 0) {
+      --lose_;
+      return net::buffer_size(buffers);
+    }
+    return socket_.send(buffers, flags, ec);
+  }
+
+  template <class MutableBufferSequence>
+  std::size_t receive(const MutableBufferSequence& buffers, udp::socket::message_flags flags, error_code& ec) {
+    return socket_.receive(buffers, flags, ec);
+  }
+
+  template <class ConstBufferSequence, class Handler>
+  void async_send(const ConstBufferSequence& buffers, Handler&& handler) {
+    if (lose_ > 0) {
+      --lose_;
+      net::post(socket_.get_executor(), [handler = std::forward<Handler>(handler), size = net::buffer_size(buffers)]() mutable {
+        handler(error_code{}, size);
+      });
+      return;
+    }
+    socket_.async_send(buffers, std::forward<Handler>(handler));
+  }
+
+  template <class MutableBufferSequence, class Handler>
+  void async_receive(const MutableBufferSequence& buffers, Handler&& handler) {
+    socket_.async_receive(buffers, std::forward<Handler>(handler));
+  }
+
+  void cancel() {
+    socket_.cancel();
+  }
+
+private:
+  udp::socket socket_;
+  int lose_ = 0;
+};
+
+struct dtls_pair {
+  explicit dtls_pair(net::io_context& ioc)
+    : client_ctx(wintls::method::dtlsv12_client)
+    , client(ioc, client_ctx)
+    , server(ioc, server_ctx) {
+    client.next_layer().connect(server.next_layer());
+  }
+
+  void handshake(net::io_context& ioc) {
+    error_code client_ec{net::error::would_block};
+    error_code server_ec{net::error::would_block};
+    client.async_handshake(wintls::handshake_type::client, [&client_ec](const error_code& ec) {
+      client_ec = ec;
+    });
+    server.async_handshake(wintls::handshake_type::server, [&server_ec](const error_code& ec) {
+      server_ec = ec;
+    });
+    ioc.run();
+    ioc.restart();
+    REQUIRE_FALSE(client_ec);
+    REQUIRE_FALSE(server_ec);
+  }
+
+  wintls::context client_ctx;
+  dtls_server_context server_ctx;
+  wintls::datagram_stream<lossy_socket> client;
+  wintls::datagram_stream<lossy_socket> server;
+};
+
+} // namespace
+
+TEST_CASE("datagram stream") {
+  net::io_context ioc;
+  dtls_pair dtls(ioc);
+
+  SECTION("send and receive") {
+    dtls.handshake(ioc);
+
+    const std::string message{"telemetry"};
+    std::string received(64, '\0');
+    std::size_t size_received = 0;
+    dtls.client.async_send(net::buffer(message), [&message](const error_code& ec, std::size_t size) {
+      REQUIRE_FALSE(ec);
+      CHECK(size == message.size());
+    });
+    dtls.server.async_receive(net::buffer(&received[0], received.size()), [&size_received](const error_code& ec, std::size_t size) {
+      REQUIRE_FALSE(ec);
+      size_received = size;
+    });
+    ioc.run();
+    CHECK(received.substr(0, size_received) == message);
+
+    // Each datagram is received on its own
+    dtls.server.send(net::buffer(message));
+    dtls.server.send(net::buffer(message, 3));
+    CHECK(dtls.client.receive(net::buffer(&received[0], received.size())) == message.size());
+    CHECK(dtls.client.receive(net::buffer(&received[0], received.size())) == 3);
+
+    // Sizes larger than a datagram of the MTU are rejected
+    const std::string too_large(dtls.client.max_message_size() + 1, 'x');
+    error_code ec{};
+    CHECK(dtls.client.send(net::buffer(too_large), ec) == 0);
+    CHECK(ec == net::error::message_size);
+  }
+
+  SECTION("several sends outstanding") {
+    dtls.handshake(ioc);
+
+    const std::string first{"first"};
+    const std::string second{"second datagram"};
+    std::string received(64, '\0');
+    dtls.client.async_send(net::buffer(first), [](const error_code& ec, std::size_t) {
+      REQUIRE_FALSE(ec);
+    });
+    dtls.client.async_send(net::buffer(second), [](const error_code& ec, std::size_t) {
+      REQUIRE_FALSE(ec);
+    });
+    ioc.run();
+    ioc.restart();
+    // Each datagram is decrypted, so neither record was overwritten
+    CHECK(received.substr(0, dtls.server.receive(net::buffer(&received[0], received.size()))) == first);
+    CHECK(received.substr(0, dtls.server.receive(net::buffer(&received[0], received.size()))) == second);
+  }
+
+  SECTION("smaller mtu") {
+    dtls.handshake(ioc);
+    const auto max_size = dtls.client.max_message_size();
+    dtls.client.set_mtu(500);
+    CHECK(dtls.client.max_message_size() < 500);
+    CHECK(dtls.client.max_message_size() < max_size);
+  }
+
+  SECTION("small mtu during handshake") {
+    // Smaller than the certificate flight of the server, which has to
+    // be fragmented by Schannel
+    dtls.client.set_mtu(300);
+    dtls.server.set_mtu(300);
+    dtls.handshake(ioc);
+    CHECK(dtls.client.max_message_size() < 300);
+
+    const std::string message{"small"};
+    dtls.client.send(net::buffer(message));
+    std::string received(message.size(), '\0');
+    CHECK(dtls.server.receive(net::buffer(&received[0], received.size())) == message.size());
+    CHECK(received == message);
+  }
+
+  SECTION("handshake retransmission") {
+    dtls.client.set_retransmit_timeout(std::chrono::milliseconds(50));
+    dtls.server.set_retransmit_timeout(std::chrono::milliseconds(50));
+    // Lose the ClientHello and the first reply of the server
+    dtls.client.next_layer().lose_next(1);
+    dtls.server.next_layer().lose_next(1);
+    dtls.handshake(ioc);
+
+    const std::string message{"after loss"};
+    dtls.client.send(net::buffer(message));
+    std::string received(message.size(), '\0');
+    CHECK(dtls.server.receive(net::buffer(&received[0], received.size())) == message.size());
+    CHECK(received == message);
+  }
+
+  SECTION("handshake timeout") {
+    dtls.client.set_retransmit_timeout(std::chrono::milliseconds(1));
+    dtls.client.next_layer().lose_next(100);
+    error_code client_ec{};
+    dtls.client.async_handshake(wintls::handshake_type::client, [&client_ec](const error_code& ec) {
+      client_ec = ec;
+    });
+    ioc.run();
+    CHECK(client_ec == net::error::timed_out);
+  }
+
+  SECTION("shutdown") {
+    dtls.handshake(ioc);
+    error_code shutdown_ec{net::error::would_block};
+    error_code receive_ec{};
+    char c{};
+    dtls.client.async_shutdown([&shutdown_ec](const error_code& ec) {
+      shutdown_ec = ec;
+    });
+    dtls.server.async_receive(net::buffer(&c, 1), [&receive_ec](const error_code& ec, std::size_t) {
+      receive_ec = ec;
+    });
+    ioc.run();
+    CHECK_FALSE(shutdown_ec);
+    CHECK(receive_ec.value() == SEC_I_CONTEXT_EXPIRED);
+  }
+}
@@ -0,0 +1,244 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "unittest.hpp"
+#include "wintls_client_stream.hpp"
+#include "wintls_server_stream.hpp"
+#include "stream_handshake.hpp"
+
+#include <wintls.hpp>
+
+#include <chrono>
+#include <string>
+
+TEST_CASE("relay") {
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+
+  // client <-> proxy_server | relay | proxy_client <-> server
+  wintls::stream<test_stream> client(ioc, client_ctx);
+  wintls::stream<test_stream> proxy_server(ioc, server_ctx);
+  wintls::stream<test_stream> proxy_client(ioc, client_ctx);
+  wintls::stream<test_stream> server(ioc, server_ctx);
+  client.next_layer().connect(proxy_server.next_layer());
+  handshake_pair(ioc, client, proxy_server);
+  proxy_client.next_layer().connect(server.next_layer());
+  handshake_pair(ioc, proxy_client, server);
+
+  error_code relay_ec{net::error::would_block};
+  wintls::async_relay(proxy_server, proxy_client, [&relay_ec](const error_code& ec) {
+    relay_ec = ec;
+  });
+
+  // Larger than a single TLS record
+  const std::string request(100000, 'q');
+  const std::string response{"response"};
+  std::string received_request(request.size(), '\0');
+  std::string received_response(response.size(), '\0');
+  error_code server_shutdown_ec{};
+  error_code client_shutdown_ec{net::error::would_block};
+  char server_byte{};
+
+  net::async_write(client, net::buffer(request), [](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+  });
+  net::async_read(server, net::buffer(&received_request[0], received_request.size()),
+                  [&](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+    net::async_write(server, net::buffer(response), [](const error_code& write_ec, std::size_t) {
+      REQUIRE_FALSE(write_ec);
+    });
+  });
+  net::async_read(client, net::buffer(&received_response[0], received_response.size()),
+                  [&](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+    // Closing from the client is forwarded to the server by the relay
+    client.async_shutdown([&](const error_code& shutdown_ec) {
+      client_shutdown_ec = shutdown_ec;
+      server.async_read_some(net::buffer(&server_byte, 1), [&](const error_code& read_ec, std::size_t) {
+        CHECK(read_ec.value() == SEC_I_CONTEXT_EXPIRED);
+        server.async_shutdown([&](const error_code& server_ec) {
+          server_shutdown_ec = server_ec;
+        });
+      });
+    });
+  });
+
+  ioc.run();
+
+  CHECK(received_request == request);
+  CHECK(received_response == response);
+  CHECK_FALSE(client_shutdown_ec);
+  CHECK_FALSE(server_shutdown_ec);
+  // The relay is done when the shutdown from the server has reached the client
+  ioc.restart();
+  char c{};
+  error_code client_read_ec{};
+  client.async_read_some(net::buffer(&c, 1), [&client_read_ec](const error_code& ec, std::size_t) {
+    client_read_ec = ec;
+  });
+  ioc.run();
+  CHECK(client_read_ec.value() == SEC_I_CONTEXT_EXPIRED);
+  CHECK_FALSE(relay_ec);
+}
+
+TEST_CASE("relay with both peers closing at once") {
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+
+  wintls::stream<test_stream> client(ioc, client_ctx);
+  wintls::stream<test_stream> proxy_server(ioc, server_ctx);
+  wintls::stream<test_stream> proxy_client(ioc, client_ctx);
+  wintls::stream<test_stream> server(ioc, server_ctx);
+  client.next_layer().connect(proxy_server.next_layer());
+  handshake_pair(ioc, client, proxy_server);
+  proxy_client.next_layer().connect(server.next_layer());
+  handshake_pair(ioc, proxy_client, server);
+
+  error_code relay_ec{net::error::would_block};
+  wintls::async_relay(proxy_server, proxy_client, [&relay_ec](const error_code& ec) {
+    relay_ec = ec;
+  });
+
+  // Each direction shuts down the stream the other direction is
+  // reading from when the shutdown of its peer arrives
+  error_code client_shutdown_ec{net::error::would_block};
+  error_code server_shutdown_ec{net::error::would_block};
+  client.async_shutdown([&client_shutdown_ec](const error_code& ec) {
+    client_shutdown_ec = ec;
+  });
+  server.async_shutdown([&server_shutdown_ec](const error_code& ec) {
+    server_shutdown_ec = ec;
+  });
+  ioc.run();
+
+  CHECK_FALSE(client_shutdown_ec);
+  CHECK_FALSE(server_shutdown_ec);
+  CHECK_FALSE(relay_ec);
+
+  // The shutdown of each peer has been forwarded to the other
+  ioc.restart();
+  char client_byte{};
+  char server_byte{};
+  error_code client_read_ec{};
+  error_code server_read_ec{};
+  client.async_read_some(net::buffer(&client_byte, 1), [&client_read_ec](const error_code& ec, std::size_t) {
+    client_read_ec = ec;
+  });
+  server.async_read_some(net::buffer(&server_byte, 1), [&server_read_ec](const error_code& ec, std::size_t) {
+    server_read_ec = ec;
+  });
+  ioc.run();
+  CHECK(client_read_ec.value() == SEC_I_CONTEXT_EXPIRED);
+  CHECK(server_read_ec.value() == SEC_I_CONTEXT_EXPIRED);
+}
+
+TEST_CASE("relay with read ahead") {
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+
+  wintls::stream<test_stream> client(ioc, client_ctx);
+  wintls::stream<test_stream> proxy_server(ioc, server_ctx);
+  wintls::stream<test_stream> proxy_client(ioc, client_ctx);
+  wintls::stream<test_stream> server(ioc, server_ctx);
+  client.next_layer().connect(proxy_server.next_layer());
+  handshake_pair(ioc, client, proxy_server);
+  proxy_client.next_layer().connect(server.next_layer());
+  handshake_pair(ioc, proxy_client, server);
+
+  // Smaller than a TLS record to require several reads ahead per record
+  proxy_server.set_read_ahead(1000);
+  proxy_client.set_read_ahead(1000);
+  wintls::async_relay(proxy_server, proxy_client, [](const error_code&) {
+  });
+
+  // The outstanding reads ahead keep the io_context from running out of work
+  auto run_until = [&ioc](const bool& done) {
+    while (!done) {
+      ioc.run_one();
+    }
+  };
+
+  std::string request(100000, '\0');
+  for (std::size_t i = 0; i < request.size(); ++i) {
+    request[i] = static_cast<char>('a' + i % 26);
+  }
+  std::string received_request(request.size(), '\0');
+  bool request_done = false;
+  net::async_write(client, net::buffer(request), [](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+  });
+  net::async_read(server, net::buffer(&received_request[0], received_request.size()),
+                  [&request_done](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+    request_done = true;
+  });
+  run_until(request_done);
+  CHECK(received_request == request);
+
+  const std::string response{"response"};
+  std::string received_response(response.size(), '\0');
+  bool response_done = false;
+  net::async_write(server, net::buffer(response), [](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+  });
+  net::async_read(client, net::buffer(&received_response[0], received_response.size()),
+                  [&response_done](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+    response_done = true;
+  });
+  run_until(response_done);
+  CHECK(received_response == response);
+}
+
+TEST_CASE("relay with write rate limit") {
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+
+  wintls::stream<test_stream> client(ioc, client_ctx);
+  wintls::stream<test_stream> proxy_server(ioc, server_ctx);
+  wintls::stream<test_stream> proxy_client(ioc, client_ctx);
+  wintls::stream<test_stream> server(ioc, server_ctx);
+  client.next_layer().connect(proxy_server.next_layer());
+  handshake_pair(ioc, client, proxy_server);
+  proxy_client.next_layer().connect(server.next_layer());
+  handshake_pair(ioc, proxy_client, server);
+
+  // Half a second worth of data more than the burst
+  const std::size_t rate = 64 * 1024;
+  const std::size_t burst = 20 * 1024;
+  proxy_client.set_write_rate_limit(rate, burst);
+  wintls::async_relay(proxy_server, proxy_client, [](const error_code&) {
+  });
+
+  const std::string request(burst + rate / 2, 'q');
+  std::string received_request(request.size(), '\0');
+  bool done = false;
+  const auto start = std::chrono::steady_clock::now();
+  net::async_write(client, net::buffer(request), [](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+  });
+  net::async_read(server, net::buffer(&received_request[0], received_request.size()),
+                  [&done](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+    done = true;
+  });
+  // The relay keeps reading from both streams
+  while (!done) {
+    ioc.run_one();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  CHECK(received_request == request);
+  // The record overhead counts towards the limit as well
+  CHECK(elapsed >= std::chrono::milliseconds(450));
+  CHECK(elapsed < std::chrono::seconds(5));
+}
@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "unittest.hpp"
+#include "wintls_client_stream.hpp"
+#include "wintls_server_stream.hpp"
+#include "stream_handshake.hpp"
+
+#include <wintls.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace {
+
+// A file in memory supporting random access reads like
+// net::windows::random_access_handle
+class memory_file {
+public:
+  memory_file(net::io_context& ioc, std::string contents)
+    : ioc_(ioc)
+    , contents_(std::move(contents)) {
+  }
+
+  template <class MutableBufferSequence, class Handler>
+  void async_read_some_at(std::uint64_t offset, const MutableBufferSequence& buffers, Handler&& handler) {
+    error_code ec{};
+    std::size_t size = 0;
+    if (offset >= contents_.size()) {
+      ec = net::error::eof;
+    } else {
+      size = net::buffer_copy(buffers, net::buffer(contents_) + static_cast<std::size_t>(offset));
+    }
+    net::post(ioc_, [handler = std::move(handler), ec, size]() mutable {
+      handler(ec, size);
+    });
+  }
+
+private:
+  net::io_context& ioc_;
+  std::string contents_;
+};
+
+} // namespace
+
+TEST_CASE("send file") {
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> client(ioc, client_ctx);
+  wintls::stream<test_stream> server(ioc, server_ctx);
+  client.next_layer().connect(server.next_layer());
+  handshake_pair(ioc, client, server);
+
+  std::string contents;
+  for (int i = 0; i < 50000; ++i) {
+    contents += static_cast<char>('a' + i % 26);
+  }
+  memory_file file(ioc, contents);
+
+  SECTION("part of file") {
+    // Larger than a single TLS record
+    const std::uint64_t offset = 100;
+    const std::uint64_t size = 40000;
+    error_code send_ec{net::error::would_block};
+    std::uint64_t size_sent = 0;
+    wintls::async_send_file(client, file, offset, size, [&](const error_code& ec, std::uint64_t n) {
+      send_ec = ec;
+      size_sent = n;
+    });
+    std::string received(static_cast<std::size_t>(size), '\0');
+    net::async_read(server, net::buffer(&received[0], received.size()), [](const error_code& ec, std::size_t) {
+      REQUIRE_FALSE(ec);
+    });
+    ioc.run();
+    CHECK_FALSE(send_ec);
+    CHECK(size_sent == size);
+    CHECK(received == contents.substr(100, 40000));
+  }
+
+  SECTION("stops at end of file") {
+    error_code send_ec{net::error::would_block};
+    std::uint64_t size_sent = 0;
+    wintls::async_send_file(client, file, 49000, 10000, [&](const error_code& ec, std::uint64_t n) {
+      send_ec = ec;
+      size_sent = n;
+    });
+    std::string received(1000, '\0');
+    net::async_read(server, net::buffer(&received[0], received.size()), [](const error_code& ec, std::size_t) {
+      REQUIRE_FALSE(ec);
+    });
+    ioc.run();
+    CHECK_FALSE(send_ec);
+    CHECK(size_sent == 1000);
+    CHECK(received == contents.substr(49000));
+  }
+
+  SECTION("write rate limit") {
+    // Half a second worth of data more than the burst
+    const std::size_t rate = 64 * 1024;
+    const std::size_t burst = 20 * 1024;
+    const std::uint64_t size = burst + rate / 2;
+    client.set_write_rate_limit(rate, burst);
+    memory_file large_file(ioc, std::string(static_cast<std::size_t>(size), 'a'));
+
+    const auto start = std::chrono::steady_clock::now();
+    error_code send_ec{net::error::would_block};
+    std::uint64_t size_sent = 0;
+    wintls::async_send_file(client, large_file, 0, size, [&](const error_code& ec, std::uint64_t n) {
+      send_ec = ec;
+      size_sent = n;
+    });
+    std::string received(static_cast<std::size_t>(size), '\0');
+    net::async_read(server, net::buffer(&received[0], received.size()), [](const error_code& ec, std::size_t) {
+      REQUIRE_FALSE(ec);
+    });
+    ioc.run();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    CHECK_FALSE(send_ec);
+    CHECK(size_sent == size);
+    CHECK(received == std::string(static_cast<std::size_t>(size), 'a'));
+    CHECK(elapsed >= std::chrono::milliseconds(450));
+    CHECK(elapsed < std::chrono::seconds(5));
+  }
+}
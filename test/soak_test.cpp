@@ -0,0 +1,363 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Long running soak test cycling a large number of in-process
+// client/server pairs through handshake, echoing random sized
+// messages, shutdown and reconnect.
+//
+// Not part of the regular test suite. Run the soak_test executable
+// manually, optionally configured using these environment variables:
+//
+//   WINTLS_SOAK_SECONDS      Total run time (default 60)
+//   WINTLS_SOAK_PAIRS        Number of concurrent client/server pairs (default 1000)
+//   WINTLS_SOAK_THREADS      Number of threads each running an io_context (default 4)
+//   WINTLS_SOAK_MAX_MESSAGE  Max size of each echoed message (default 256 KiB)
+//   WINTLS_SOAK_INTERVAL     Seconds between progress reports (default 10)
+
+#include "unittest.hpp"
+#include "wintls_server_stream.hpp"
+
+#include <wintls.hpp>
+
+#include <psapi.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::size_t env_or(const char* name, std::size_t default_value) {
+  const char* value = std::getenv(name);
+  if (value == nullptr) {
+    return default_value;
+  }
+  return static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+}
+
+std::chrono::seconds env_seconds_or(const char* name, std::size_t default_value) {
+  return std::chrono::seconds{static_cast<std::chrono::seconds::rep>(env_or(name, default_value))};
+}
+
+struct soak_config {
+  std::chrono::seconds duration{env_seconds_or("WINTLS_SOAK_SECONDS", 60)};
+  std::size_t pairs{env_or("WINTLS_SOAK_PAIRS", 1000)};
+  std::size_t threads{std::max<std::size_t>(env_or("WINTLS_SOAK_THREADS", 4), 1)};
+  std::size_t max_message{std::max<std::size_t>(env_or("WINTLS_SOAK_MAX_MESSAGE", 0x40000), 1)};
+  std::chrono::seconds interval{std::max(env_seconds_or("WINTLS_SOAK_INTERVAL", 10), std::chrono::seconds{1})};
+};
+
+struct soak_stats {
+  std::atomic<std::uint64_t> handshakes{0};
+  std::atomic<std::uint64_t> cycles{0};
+  std::atomic<std::uint64_t> bytes{0};
+  std::atomic<std::uint64_t> errors{0};
+  std::atomic<std::size_t> active_pairs{0};
+
+  void fail(const char* what, const error_code& ec) {
+    if (errors++ == 0) {
+      std::lock_guard<std::mutex> lock(mutex);
+      first_error = std::string{what} + ": " + ec.message();
+    }
+  }
+
+  std::mutex mutex;
+  std::string first_error;
+};
+
+struct process_usage {
+  std::size_t private_bytes;
+  std::size_t peak_private_bytes;
+  DWORD handles;
+};
+
+process_usage current_process_usage() {
+  PROCESS_MEMORY_COUNTERS_EX counters{};
+  counters.cb = sizeof(counters);
+  GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters));
+  DWORD handles = 0;
+  GetProcessHandleCount(GetCurrentProcess(), &handles);
+  return {counters.PrivateUsage, counters.PeakPagefileUsage, handles};
+}
+
+long live_ctxt_handles() {
+  return wintls::detail::handle_counter<wintls::detail::ctxt_handle>::live();
+}
+
+long live_cred_handles() {
+  return wintls::detail::handle_counter<wintls::detail::cred_handle>::live();
+}
+
+long live_context_buffers() {
+  return wintls::detail::handle_counter<wintls::detail::sspi_context_buffer>::live();
+}
+
+// A client and a server stream connected to each other, repeatedly
+// doing handshake, a random number of echoes of random sized
+// messages and shutdown until the deadline is reached.
+class soak_pair {
+public:
+  soak_pair(net::io_context& ioc,
+            wintls::context& client_ctx,
+            wintls::context& server_ctx,
+            const soak_config& config,
+            soak_stats& stats,
+            std::chrono::steady_clock::time_point deadline,
+            std::uint32_t seed)
+    : ioc_(ioc)
+    , client_ctx_(client_ctx)
+    , server_ctx_(server_ctx)
+    , config_(config)
+    , stats_(stats)
+    , deadline_(deadline)
+    , rng_(seed)
+    , server_buffer_(0x4000) {
+  }
+
+  void run() {
+    ++stats_.active_pairs;
+    connect();
+  }
+
+private:
+  void connect() {
+    client_ = std::make_unique<wintls::stream<test_stream>>(ioc_, client_ctx_);
+    server_ = std::make_unique<wintls::stream<test_stream>>(ioc_, server_ctx_);
+    client_->next_layer().connect(server_->next_layer());
+    sides_running_ = 2;
+    failed_ = false;
+
+    server_->async_handshake(wintls::handshake_type::server, [this](const error_code& ec) {
+      if (ec) {
+        return fail("server handshake", ec);
+      }
+      ++stats_.handshakes;
+      do_server_read();
+    });
+
+    client_->async_handshake(wintls::handshake_type::client, [this](const error_code& ec) {
+      if (ec) {
+        return fail("client handshake", ec);
+      }
+      ++stats_.handshakes;
+      rounds_left_ = std::uniform_int_distribution<int>{1, 8}(rng_);
+      do_client_write();
+    });
+  }
+
+  void do_client_write() {
+    const auto size = std::uniform_int_distribution<std::size_t>{1, config_.max_message}(rng_);
+    client_data_.resize(size);
+    std::generate(client_data_.begin(), client_data_.end(), [this]() {
+      return static_cast<char>(rng_());
+    });
+    net::async_write(*client_, net::buffer(client_data_), [this](const error_code& ec, std::size_t) {
+      if (ec) {
+        return fail("client write", ec);
+      }
+      do_client_read();
+    });
+  }
+
+  void do_client_read() {
+    echoed_data_.resize(client_data_.size());
+    net::async_read(*client_, net::buffer(echoed_data_), [this](const error_code& ec, std::size_t length) {
+      if (ec) {
+        return fail("client read", ec);
+      }
+      if (echoed_data_ != client_data_) {
+        return fail("client read", net::error::invalid_argument);
+      }
+      stats_.bytes += 2 * length;
+      if (--rounds_left_ > 0) {
+        return do_client_write();
+      }
+      client_->async_shutdown([this](const error_code& shutdown_ec) {
+        if (shutdown_ec) {
+          return fail("client shutdown", shutdown_ec);
+        }
+        side_done();
+      });
+    });
+  }
+
+  void do_server_read() {
+    server_->async_read_some(net::buffer(server_buffer_), [this](const error_code& ec, std::size_t length) {
+      if (ec.value() == SEC_I_CONTEXT_EXPIRED) {
+        // The client has shut down the TLS channel
+        server_->async_shutdown([this](const error_code& shutdown_ec) {
+          if (shutdown_ec) {
+            return fail("server shutdown", shutdown_ec);
+          }
+          side_done();
+        });
+        return;
+      }
+      if (ec) {
+        return fail("server read", ec);
+      }
+      net::async_write(*server_, net::buffer(server_buffer_, length), [this](const error_code& write_ec, std::size_t) {
+        if (write_ec) {
+          return fail("server write", write_ec);
+        }
+        do_server_read();
+      });
+    });
+  }
+
+  void fail(const char* what, const error_code& ec) {
+    if (!failed_) {
+      failed_ = true;
+      stats_.fail(what, ec);
+      // Make sure the other side doesn't wait forever
+      client_->next_layer().close();
+      server_->next_layer().close();
+    }
+    side_done();
+  }
+
+  void side_done() {
+    if (--sides_running_ > 0) {
+      return;
+    }
+    ++stats_.cycles;
+    // Destroy the streams outside of their own completion handlers
+    net::post(ioc_, [this]() {
+      client_.reset();
+      server_.reset();
+      if (failed_ || std::chrono::steady_clock::now() >= deadline_) {
+        --stats_.active_pairs;
+        return;
+      }
+      connect();
+    });
+  }
+
+  net::io_context& ioc_;
+  wintls::context& client_ctx_;
+  wintls::context& server_ctx_;
+  const soak_config& config_;
+  soak_stats& stats_;
+  std::chrono::steady_clock::time_point deadline_;
+  std::mt19937 rng_;
+  std::unique_ptr<wintls::stream<test_stream>> client_;
+  std::unique_ptr<wintls::stream<test_stream>> server_;
+  std::vector<char> client_data_;
+  std::vector<char> echoed_data_;
+  std::vector<char> server_buffer_;
+  int rounds_left_ = 0;
+  int sides_running_ = 0;
+  bool failed_ = false;
+};
+
+} // namespace
+
+TEST_CASE("soak") {
+  const soak_config config;
+  soak_stats stats;
+
+  wintls::context client_ctx{wintls::method::system_default};
+  wintls_server_context server_ctx;
+
+  std::vector<std::unique_ptr<net::io_context>> io_contexts;
+  for (std::size_t i = 0; i < config.threads; ++i) {
+    io_contexts.push_back(std::make_unique<net::io_context>(1));
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + config.duration;
+
+  std::vector<std::unique_ptr<soak_pair>> pairs;
+  for (std::size_t i = 0; i < config.pairs; ++i) {
+    auto& ioc = *io_contexts[i % io_contexts.size()];
+    pairs.push_back(std::make_unique<soak_pair>(ioc, client_ctx, server_ctx, config, stats, deadline, static_cast<std::uint32_t>(i)));
+    pairs.back()->run();
+  }
+
+  std::vector<std::thread> threads;
+  for (auto& ioc : io_contexts) {
+    threads.emplace_back([&ioc]() {
+      ioc->run();
+    });
+  }
+
+  std::cout << "soak: " << config.pairs << " pairs on " << config.threads << " threads for "
+            << config.duration.count() << " seconds\n";
+
+  std::vector<double> throughputs;
+  process_usage first_usage{};
+  process_usage last_usage{};
+  std::uint64_t last_bytes = 0;
+  auto last_report = start;
+  while (stats.active_pairs > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_report < config.interval && stats.active_pairs > 0) {
+      continue;
+    }
+
+    const std::chrono::duration<double> elapsed = now - last_report;
+    const std::uint64_t bytes = stats.bytes;
+    const double mib_per_second = static_cast<double>(bytes - last_bytes) / elapsed.count() / 0x100000;
+    last_report = now;
+    last_bytes = bytes;
+
+    last_usage = current_process_usage();
+    if (throughputs.empty()) {
+      first_usage = last_usage;
+    }
+    throughputs.push_back(mib_per_second);
+
+    std::cout << "soak: " << std::chrono::duration_cast<std::chrono::seconds>(now - start).count() << "s"
+              << " handshakes=" << stats.handshakes
+              << " cycles=" << stats.cycles
+              << " errors=" << stats.errors
+              << " MiB/s=" << mib_per_second
+              << " ctxt_handles=" << live_ctxt_handles()
+              << " cred_handles=" << live_cred_handles()
+              << " context_buffers=" << live_context_buffers()
+              << " private_bytes=" << last_usage.private_bytes
+              << " peak_private_bytes=" << last_usage.peak_private_bytes
+              << " os_handles=" << last_usage.handles << std::endl;
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  pairs.clear();
+
+  INFO(stats.first_error);
+  CHECK(stats.errors == 0);
+  CHECK(stats.handshakes >= 2 * config.pairs);
+
+  // Every SSPI resource must have been released once all streams are gone
+  CHECK(live_ctxt_handles() == 0);
+  CHECK(live_cred_handles() == 0);
+  CHECK(live_context_buffers() == 0);
+
+  // Gradual slowdowns and memory growth are reported but not treated
+  // as failures as they depend on the machine running the test
+  if (throughputs.size() > 2) {
+    // Skip the first interval as it includes the initial ramp up
+    const double first = throughputs[1];
+    const double last = throughputs[throughputs.size() - 2];
+    if (last < first * 0.8) {
+      WARN("Throughput dropped from " << first << " MiB/s to " << last << " MiB/s");
+    }
+    if (last_usage.private_bytes > first_usage.private_bytes + first_usage.private_bytes / 10) {
+      WARN("Private bytes grew from " << first_usage.private_bytes << " to " << last_usage.private_bytes);
+    }
+  }
+}
@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2026 Kasper Laudrup (laudrup at stacktrace dot dk)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef WINTLS_TEST_STREAM_HANDSHAKE_HPP
+#define WINTLS_TEST_STREAM_HANDSHAKE_HPP
+
+#include "unittest.hpp"
+
+#include <wintls.hpp>
+
+// Perform the TLS handshake on two connected streams, running the
+// io_context until both sides are done. The io_context is restarted
+// afterwards so it can be run again by the test.
+template <class ClientNextLayer, class ServerNextLayer>
+void handshake_pair(net::io_context& ioc,
+                    wintls::stream<ClientNextLayer>& client,
+                    wintls::stream<ServerNextLayer>& server) {
+  error_code client_ec{};
+  error_code server_ec{};
+  client.async_handshake(wintls::handshake_type::client, [&client_ec](const error_code& ec) {
+    client_ec = ec;
+  });
+  server.async_handshake(wintls::handshake_type::server, [&server_ec](const error_code& ec) {
+    server_ec = ec;
+  });
+  ioc.restart();
+  ioc.run();
+  ioc.restart();
+  REQUIRE_FALSE(client_ec);
+  REQUIRE_FALSE(server_ec);
+}
+
+#endif // WINTLS_TEST_STREAM_HANDSHAKE_HPP
@@ -9,6 +9,7 @@
 #include "asio_ssl_server_stream.hpp"
 #include "wintls_client_stream.hpp"
 #include "wintls_server_stream.hpp"
+#include "stream_handshake.hpp"
 #include "echo_client.hpp"
 #include "echo_server.hpp"
 #include "async_echo_client.hpp"
@@ -23,9 +24,12 @@
 #include <boost/asio/io_context.hpp>
 #endif // !WINTLS_USE_STANDALONE_ASIO
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <thread>
 #include <string>
+#include <vector>
 
 class test_server : public async_echo_server<asio_ssl_server_stream> {
 public:
@@ -256,3 +260,775 @@ TEST_CASE("small reads") {
     CHECK(client.data<std::string>() == test_data);
   }
 }
+
+TEST_CASE("split stream") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  const std::size_t messages = 100;
+  const std::string message(1000, 'a');
+  const std::size_t total = messages * message.size();
+
+  // Echo everything received back to the client
+  std::thread server_thread([&server_stream, total]() {
+    std::array<char, 4096> buf{};
+    std::size_t echoed = 0;
+    while (echoed < total) {
+      const auto n = server_stream.read_some(net::buffer(buf));
+      net::write(server_stream, net::buffer(buf.data(), n));
+      echoed += n;
+    }
+  });
+
+  auto halves = client_stream.split();
+  auto& reader = halves.first;
+  auto& writer = halves.second;
+
+  // Read and write concurrently from different threads
+  std::string received;
+  std::thread read_thread([&reader, &received, total]() {
+    std::array<char, 4096> buf{};
+    while (received.size() < total) {
+      const auto n = reader.read_some(net::buffer(buf));
+      received.append(buf.data(), n);
+    }
+  });
+  std::thread write_thread([&writer, &message, messages]() {
+    for (std::size_t i = 0; i < messages; ++i) {
+      net::write(writer, net::buffer(message));
+    }
+  });
+
+  write_thread.join();
+  read_thread.join();
+  server_thread.join();
+
+  CHECK(received == std::string(total, 'a'));
+}
+
+TEST_CASE("rebind stream to another executor") {
+  using tcp = net::ip::tcp;
+  net::io_context accept_ioc;
+  net::io_context worker_ioc;
+
+  wintls_server_context server_ctx;
+  wintls_client_context client_ctx;
+
+  tcp::acceptor acceptor{accept_ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}};
+  wintls::stream<tcp::socket> client_stream(accept_ioc, client_ctx);
+  wintls::stream<tcp::socket> server_stream(accept_ioc, server_ctx);
+
+  client_stream.next_layer().connect(acceptor.local_endpoint());
+  acceptor.accept(server_stream.next_layer());
+
+  handshake_pair(accept_ioc, client_stream, server_stream);
+
+  // Send data before moving, so it is buffered by the socket
+  const std::string message{"hello"};
+  net::write(client_stream, net::buffer(message));
+
+  const auto protocol = server_stream.next_layer().local_endpoint().protocol();
+  const auto handle = server_stream.next_layer().release();
+  auto moved_stream = server_stream.release_and_rebind(tcp::socket{worker_ioc, protocol, handle});
+
+  std::string received(message.size(), '\0');
+  error_code read_ec{};
+  net::async_read(moved_stream, net::buffer(&received[0], received.size()),
+                  [&read_ec](const error_code& ec, std::size_t) {
+    read_ec = ec;
+  });
+  worker_ioc.run();
+  CHECK_FALSE(read_ec);
+  CHECK(received == message);
+
+  // The new stream keeps encrypting with the established context
+  net::write(moved_stream, net::buffer(message));
+  std::string echoed(message.size(), '\0');
+  net::read(client_stream, net::buffer(&echoed[0], echoed.size()));
+  CHECK(echoed == message);
+}
+
+TEST_CASE("rebind stream with read ahead") {
+  using tcp = net::ip::tcp;
+  net::io_context accept_ioc;
+  net::io_context worker_ioc;
+
+  wintls_server_context server_ctx;
+  wintls_client_context client_ctx;
+
+  tcp::acceptor acceptor{accept_ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}};
+  wintls::stream<tcp::socket> client_stream(accept_ioc, client_ctx);
+  wintls::stream<tcp::socket> server_stream(accept_ioc, server_ctx);
+
+  client_stream.next_layer().connect(acceptor.local_endpoint());
+  acceptor.accept(server_stream.next_layer());
+
+  handshake_pair(accept_ioc, client_stream, server_stream);
+
+  server_stream.set_read_ahead(1000);
+  const std::string first{"first"};
+  net::write(client_stream, net::buffer(first));
+  std::string received_first(first.size(), '\0');
+  bool done = false;
+  net::async_read(server_stream, net::buffer(&received_first[0], received_first.size()),
+                  [&done](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+    done = true;
+  });
+  while (!done) {
+    accept_ioc.run_one();
+  }
+  CHECK(received_first == first);
+
+  // The read ahead started by the read is still outstanding
+  CHECK_THROWS_AS(server_stream.release_and_rebind(tcp::socket{worker_ioc}), wintls::system_error);
+
+  // Data read ahead while stopping is moved along with the stream
+  const std::string second{"second"};
+  net::write(client_stream, net::buffer(second));
+  done = false;
+  server_stream.async_stop_read_ahead([&done](const error_code& ec) {
+    CHECK_FALSE(ec);
+    done = true;
+  });
+  while (!done) {
+    accept_ioc.run_one();
+  }
+
+  const auto protocol = server_stream.next_layer().local_endpoint().protocol();
+  const auto handle = server_stream.next_layer().release();
+  auto moved_stream = server_stream.release_and_rebind(tcp::socket{worker_ioc, protocol, handle});
+
+  // Reads ahead of the moved stream complete on the new executor
+  moved_stream.set_read_ahead(1000);
+  std::string received_second(second.size(), '\0');
+  error_code read_ec{net::error::would_block};
+  net::async_read(moved_stream, net::buffer(&received_second[0], received_second.size()),
+                  [&read_ec](const error_code& ec, std::size_t) {
+    read_ec = ec;
+  });
+  while (read_ec == net::error::would_block) {
+    worker_ioc.run_one();
+  }
+  CHECK_FALSE(read_ec);
+  CHECK(received_second == second);
+
+  const std::string third{"third"};
+  net::write(client_stream, net::buffer(third));
+  std::string received_third(third.size(), '\0');
+  read_ec = net::error::would_block;
+  net::async_read(moved_stream, net::buffer(&received_third[0], received_third.size()),
+                  [&read_ec](const error_code& ec, std::size_t) {
+    read_ec = ec;
+  });
+  while (read_ec == net::error::would_block) {
+    worker_ioc.run_one();
+  }
+  CHECK_FALSE(read_ec);
+  CHECK(received_third == third);
+}
+
+TEST_CASE("export and import session") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  // Leave both decrypted and undecrypted data buffered in the exported stream
+  const std::string first{"hello"};
+  const std::string second{"world"};
+  net::write(client_stream, net::buffer(first));
+  char c{};
+  REQUIRE(server_stream.read_some(net::buffer(&c, 1)) == 1);
+  CHECK(c == 'h');
+  net::write(client_stream, net::buffer(second));
+
+  const auto session = server_stream.export_session();
+
+  wintls::stream<test_stream> imported_stream(std::move(server_stream.next_layer()), server_ctx);
+  imported_stream.import_session(net::buffer(session));
+
+  std::string received(first.size() + second.size() - 1, '\0');
+  net::read(imported_stream, net::buffer(&received[0], received.size()));
+  CHECK(received == "elloworld");
+
+  net::write(imported_stream, net::buffer(first));
+  std::string echoed(first.size(), '\0');
+  net::read(client_stream, net::buffer(&echoed[0], echoed.size()));
+  CHECK(echoed == first);
+
+  SECTION("invalid session") {
+    wintls::stream<test_stream> stream(ioc, server_ctx);
+    error_code ec{};
+    stream.import_session(net::buffer(session.data(), session.size() - 1), ec);
+    CHECK(ec);
+  }
+
+  SECTION("session already established") {
+    error_code ec{};
+    imported_stream.import_session(net::buffer(session), ec);
+    CHECK(ec);
+  }
+}
+
+TEST_CASE("export session with read ahead") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  server_stream.set_read_ahead(1000);
+  const std::string first{"first"};
+  net::write(client_stream, net::buffer(first));
+  std::string received_first(first.size(), '\0');
+  bool done = false;
+  net::async_read(server_stream, net::buffer(&received_first[0], received_first.size()),
+                  [&done](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+    done = true;
+  });
+  while (!done) {
+    ioc.run_one();
+  }
+  CHECK(received_first == first);
+
+  // The read ahead started by the read is still outstanding
+  error_code export_ec{};
+  CHECK(server_stream.export_session(export_ec).empty());
+  CHECK(export_ec == net::error::in_progress);
+
+  // Data read ahead while stopping is included in the session
+  const std::string second{"second"};
+  net::write(client_stream, net::buffer(second));
+  done = false;
+  server_stream.async_stop_read_ahead([&done](const error_code& ec) {
+    CHECK_FALSE(ec);
+    done = true;
+  });
+  while (!done) {
+    ioc.run_one();
+  }
+
+  const auto session = server_stream.export_session();
+  wintls::stream<test_stream> imported_stream(std::move(server_stream.next_layer()), server_ctx);
+  imported_stream.import_session(net::buffer(session));
+
+  std::string received_second(second.size(), '\0');
+  net::read(imported_stream, net::buffer(&received_second[0], received_second.size()));
+  CHECK(received_second == second);
+}
+
+TEST_CASE("write rate limit") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  // Half a second worth of data more than the burst
+  const std::size_t rate = 64 * 1024;
+  const std::size_t burst = 20 * 1024;
+  const std::string message(burst + rate / 2, 'a');
+  client_stream.set_write_rate_limit(rate, burst);
+
+  const auto start = std::chrono::steady_clock::now();
+  error_code write_ec{net::error::would_block};
+  net::async_write(client_stream, net::buffer(message), [&write_ec](const error_code& ec, std::size_t) {
+    write_ec = ec;
+  });
+  std::string received(message.size(), '\0');
+  net::async_read(server_stream, net::buffer(&received[0], received.size()), [](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+  });
+  ioc.run();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  CHECK_FALSE(write_ec);
+  CHECK(received == message);
+  // The record overhead counts towards the limit as well
+  CHECK(elapsed >= std::chrono::milliseconds(450));
+  CHECK(elapsed < std::chrono::seconds(5));
+}
+
+TEST_CASE("buffered byte counts") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  std::vector<bool> notifications;
+  server_stream.set_buffer_watermarks(100, 500, [&notifications](bool above) {
+    notifications.push_back(above);
+  });
+
+  CHECK(server_stream.pending_plaintext() == 0);
+  CHECK(server_stream.pending_ciphertext_in() == 0);
+  CHECK(client_stream.pending_ciphertext_out() == 0);
+
+  const std::string message(1000, 'a');
+  net::write(client_stream, net::buffer(message));
+  CHECK(client_stream.pending_ciphertext_out() == 0);
+
+  std::array<char, 10> buf{};
+  REQUIRE(server_stream.read_some(net::buffer(buf)) == buf.size());
+  CHECK(server_stream.pending_plaintext() == message.size() - buf.size());
+  CHECK(server_stream.pending_ciphertext_in() == 0);
+  CHECK(notifications == std::vector<bool>{true});
+
+  std::string rest(message.size() - buf.size(), '\0');
+  net::read(server_stream, net::buffer(&rest[0], rest.size()));
+  CHECK(server_stream.pending_plaintext() == 0);
+  CHECK(notifications == std::vector<bool>{true, false});
+}
+
+TEST_CASE("write batches records") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  // Several TLS records are written by a single call
+  std::string message(100000, '\0');
+  for (std::size_t i = 0; i < message.size(); ++i) {
+    message[i] = static_cast<char>('a' + i % 26);
+  }
+  const auto nwrite = client_stream.next_layer().nwrite();
+  const auto written = client_stream.write_some(std::array<net::const_buffer, 2>{
+    net::buffer(message.data(), 10), net::buffer(message.data() + 10, message.size() - 10)});
+  CHECK(written > 16384);
+  CHECK(written < message.size());
+  CHECK(client_stream.next_layer().nwrite() == nwrite + 1);
+
+  std::string received(written, '\0');
+  net::read(server_stream, net::buffer(&received[0], received.size()));
+  CHECK(received == message.substr(0, written));
+}
+
+TEST_CASE("partial reads of several records") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  std::string message(50000, '\0');
+  for (std::size_t i = 0; i < message.size(); ++i) {
+    message[i] = static_cast<char>('a' + i % 26);
+  }
+  net::write(client_stream, net::buffer(message));
+
+  // Decrypted data is handed out while the following records are
+  // still buffered
+  std::string received(message.size(), '\0');
+  std::size_t size_received = server_stream.read_some(net::buffer(&received[0], 7));
+  REQUIRE(size_received == 7);
+  CHECK(server_stream.pending_plaintext() != 0);
+  CHECK(server_stream.pending_ciphertext_in() != 0);
+
+  while (size_received != received.size()) {
+    const auto size = std::min(std::size_t{1000}, received.size() - size_received);
+    size_received += server_stream.read_some(net::buffer(&received[size_received], size));
+  }
+  CHECK(received == message);
+  CHECK(server_stream.pending_plaintext() == 0);
+  CHECK(server_stream.pending_ciphertext_in() == 0);
+}
+
+TEST_CASE("read ahead") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  // Smaller than a TLS record to require several reads ahead per record
+  server_stream.set_read_ahead(1000);
+
+  // The outstanding read ahead keeps the io_context from running out of work
+  error_code read_ec{net::error::would_block};
+  auto run_until_read = [&ioc, &read_ec] {
+    while (read_ec == net::error::would_block) {
+      ioc.run_one();
+    }
+  };
+
+  std::string message(50000, '\0');
+  for (std::size_t i = 0; i < message.size(); ++i) {
+    message[i] = static_cast<char>('a' + i % 26);
+  }
+  std::string received(message.size(), '\0');
+  net::async_write(client_stream, net::buffer(message), [](const error_code& ec, std::size_t) {
+    REQUIRE_FALSE(ec);
+  });
+  net::async_read(server_stream, net::buffer(&received[0], received.size()),
+                  [&read_ec](const error_code& ec, std::size_t) {
+    read_ec = ec;
+  });
+  run_until_read();
+  CHECK_FALSE(read_ec);
+  CHECK(received == message);
+
+  // A read of the next layer is outstanding after the read completed
+  char c{};
+  error_code sync_ec{};
+  CHECK(server_stream.read_some(net::buffer(&c, 1), sync_ec) == 0);
+  CHECK(sync_ec == net::error::in_progress);
+
+  // The next read continues with the data read ahead
+  const std::string second{"more data"};
+  net::write(client_stream, net::buffer(second));
+  server_stream.set_read_ahead(0);
+  std::string received_second(second.size(), '\0');
+  read_ec = net::error::would_block;
+  net::async_read(server_stream, net::buffer(&received_second[0], received_second.size()),
+                  [&read_ec](const error_code& ec, std::size_t) {
+    read_ec = ec;
+  });
+  run_until_read();
+  CHECK_FALSE(read_ec);
+  CHECK(received_second == second);
+
+  const std::string third{"third"};
+  net::write(client_stream, net::buffer(third));
+  std::string received_third(third.size(), '\0');
+  net::read(server_stream, net::buffer(&received_third[0], received_third.size()));
+  CHECK(received_third == third);
+}
+
+TEST_CASE("adaptive read size") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  const std::string small_message{"ping"};
+  std::string received(small_message.size(), '\0');
+
+  SECTION("all free space offered by default") {
+    net::write(client_stream, net::buffer(small_message));
+    net::read(server_stream, net::buffer(&received[0], received.size()));
+    const auto stats = server_stream.read_stats();
+    CHECK(stats.reads == 1);
+    CHECK(stats.records == 1);
+    CHECK(stats.read_size > 0x8000);
+  }
+
+  SECTION("adaptive") {
+    server_stream.set_adaptive_read_size(true);
+
+    // Small records keep reads small
+    for (int i = 0; i < 10; ++i) {
+      net::write(client_stream, net::buffer(small_message));
+      net::read(server_stream, net::buffer(&received[0], received.size()));
+      CHECK(received == small_message);
+    }
+    auto stats = server_stream.read_stats();
+    CHECK(stats.records == 10);
+    CHECK(stats.average_record_size < 0x100);
+    CHECK(stats.read_size == wintls::detail::min_adaptive_read_size);
+
+    // Reads grow for bulk transfers
+    std::string message(100000, '\0');
+    for (std::size_t i = 0; i < message.size(); ++i) {
+      message[i] = static_cast<char>('a' + i % 26);
+    }
+    net::write(client_stream, net::buffer(message));
+    std::string received_bulk(message.size(), '\0');
+    net::read(server_stream, net::buffer(&received_bulk[0], received_bulk.size()));
+    CHECK(received_bulk == message);
+    stats = server_stream.read_stats();
+    CHECK(stats.full_reads != 0);
+    CHECK(stats.average_record_size > 0x1000);
+    CHECK(stats.bytes_read > message.size());
+  }
+}
+
+TEST_CASE("abortive close") {
+  net::io_context ioc;
+
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> server_stream(ioc, server_ctx);
+
+  wintls_client_context client_ctx;
+  wintls::stream<test_stream> client_stream(ioc, client_ctx);
+
+  client_stream.next_layer().connect(server_stream.next_layer());
+
+  handshake_pair(ioc, client_stream, server_stream);
+
+  error_code shutdown_ec{net::error::would_block};
+  client_stream.async_shutdown([&shutdown_ec](const error_code& ec) {
+    shutdown_ec = ec;
+  });
+  ioc.run();
+  CHECK_FALSE(shutdown_ec);
+  CHECK(client_ctx.statistics().shutdowns == 1);
+  CHECK(client_ctx.statistics().aborts == 0);
+
+  // Nothing is sent to the peer
+  const auto nwrite = server_stream.next_layer().nwrite();
+  server_stream.abort();
+  CHECK(server_stream.next_layer().nwrite() == nwrite);
+  CHECK(server_ctx.statistics().shutdowns == 0);
+  CHECK(server_ctx.statistics().aborts == 1);
+  server_stream.next_layer().close();
+}
+
+TEST_CASE("drain streams of a context") {
+  net::io_context ioc;
+  net::io_context server_ioc;
+
+  wintls_server_context server_ctx;
+  wintls_client_context client_ctx;
+  server_ctx.track_streams(true);
+
+  std::vector<wintls::stream<test_stream>> server_streams;
+  std::vector<wintls::stream<test_stream>> client_streams;
+  for (int i = 0; i < 2; ++i) {
+    server_streams.emplace_back(server_ioc, server_ctx);
+    client_streams.emplace_back(ioc, client_ctx);
+    client_streams.back().next_layer().connect(server_streams.back().next_layer());
+  }
+  CHECK(server_ctx.statistics().streams == 2);
+
+  {
+    wintls::stream<test_stream> unused_stream(ioc, server_ctx);
+    CHECK(server_ctx.statistics().streams == 3);
+  }
+  CHECK(server_ctx.statistics().streams == 2);
+
+  std::vector<error_code> handshake_ecs(4, error_code{net::error::would_block});
+  for (std::size_t i = 0; i < 2; ++i) {
+    client_streams[i].async_handshake(wintls::handshake_type::client, [&handshake_ecs, i](const error_code& ec) {
+      handshake_ecs[i] = ec;
+    });
+    server_streams[i].async_handshake(wintls::handshake_type::server, [&handshake_ecs, i](const error_code& ec) {
+      handshake_ecs[i + 2] = ec;
+    });
+  }
+  while (std::any_of(handshake_ecs.begin(), handshake_ecs.end(), [](const error_code& ec) {
+    return ec == net::error::would_block;
+  })) {
+    ioc.poll();
+    server_ioc.poll();
+    ioc.restart();
+    server_ioc.restart();
+  }
+  for (const auto& ec : handshake_ecs) {
+    REQUIRE_FALSE(ec);
+  }
+
+  SECTION("all streams shut down") {
+    error_code drain_ec{net::error::would_block};
+    server_ctx.async_drain(ioc.get_executor(), std::chrono::steady_clock::now() + std::chrono::seconds(10), 1,
+                           [&drain_ec](const error_code& ec) {
+                             drain_ec = ec;
+                           });
+    server_ioc.run();
+    ioc.run();
+    CHECK_FALSE(drain_ec);
+
+    const auto stats = server_ctx.statistics();
+    CHECK(stats.drain_streams == 2);
+    CHECK(stats.drain_shutdowns == 2);
+    CHECK(stats.drain_failures == 0);
+    CHECK(stats.drain_aborts == 0);
+    CHECK(stats.shutdowns == 2);
+
+    // The clients receive the close_notify alerts
+    for (auto& client_stream : client_streams) {
+      std::array<char, 16> buffer{};
+      error_code read_ec{};
+      client_stream.read_some(net::buffer(buffer), read_ec);
+      CHECK(read_ec);
+    }
+  }
+
+  SECTION("remaining streams closed at the deadline") {
+    error_code drain_ec{net::error::would_block};
+    server_ctx.async_drain(ioc.get_executor(), std::chrono::steady_clock::now() + std::chrono::milliseconds(10), 2,
+                           [&drain_ec](const error_code& ec) {
+                             drain_ec = ec;
+                           });
+    // The executor of the server streams isn't run before the
+    // deadline, so none of the shutdowns get a chance to start
+    ioc.run_for(std::chrono::milliseconds(50));
+    server_ioc.run();
+    ioc.run();
+    CHECK(drain_ec == net::error::timed_out);
+
+    const auto stats = server_ctx.statistics();
+    CHECK(stats.drain_streams == 2);
+    CHECK(stats.drain_shutdowns == 0);
+    CHECK(stats.drain_aborts == 2);
+    CHECK(stats.shutdowns == 0);
+  }
+}
+
+TEST_CASE("drain without streams") {
+  net::io_context ioc;
+  wintls_server_context server_ctx;
+  wintls::stream<test_stream> stream(ioc, server_ctx);
+
+  SECTION("streams not tracked") {
+    error_code drain_ec{net::error::would_block};
+    server_ctx.async_drain(ioc.get_executor(), std::chrono::steady_clock::now() + std::chrono::seconds(10), 1,
+                           [&drain_ec](const error_code& ec) {
+                             drain_ec = ec;
+                           });
+    CHECK(drain_ec == net::error::would_block);
+    ioc.run();
+    CHECK(drain_ec == net::error::operation_not_supported);
+  }
+
+  SECTION("no tracked streams") {
+    // Only streams constructed afterwards are tracked
+    server_ctx.track_streams(true);
+    error_code drain_ec{net::error::would_block};
+    server_ctx.async_drain(ioc.get_executor(), std::chrono::steady_clock::now() + std::chrono::seconds(10), 1,
+                           [&drain_ec](const error_code& ec) {
+                             drain_ec = ec;
+                           });
+    CHECK(drain_ec == net::error::would_block);
+    ioc.run();
+    CHECK_FALSE(drain_ec);
+    CHECK(server_ctx.statistics().drain_streams == 0);
+  }
+}
+
+TEST_CASE("sync operations with deadline") {
+  using tcp = net::ip::tcp;
+  using namespace std::chrono_literals;
+
+  net::io_context ioc;
+  wintls_client_context client_ctx;
+  wintls_server_context server_ctx;
+
+  tcp::acceptor acceptor{ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}};
+  wintls::stream<tcp::socket> client_stream(ioc, client_ctx);
+  client_stream.next_layer().connect(acceptor.local_endpoint());
+  wintls::stream<tcp::socket> server_stream(acceptor.accept(), server_ctx);
+
+  SECTION("handshake times out") {
+    // The server never answers
+    error_code ec{};
+    const auto start = std::chrono::steady_clock::now();
+    client_stream.handshake(wintls::handshake_type::client, start + 100ms, ec);
+    CHECK(ec == net::error::timed_out);
+    CHECK(std::chrono::steady_clock::now() - start >= 100ms);
+
+    // A deadline which has already passed times out right away, which
+    // the overload without an error code reports by throwing
+    wintls::stream<tcp::socket> other_stream(ioc, client_ctx);
+    other_stream.next_layer().connect(acceptor.local_endpoint());
+    CHECK_THROWS_AS(other_stream.handshake(wintls::handshake_type::client, std::chrono::steady_clock::now()),
+                    wintls::system_error);
+  }
+
+  SECTION("read times out and can be retried") {
+    error_code server_ec{};
+    std::thread server_thread([&server_stream, &server_ec]() {
+      server_stream.handshake(wintls::handshake_type::server, server_ec);
+    });
+    error_code client_ec{};
+    client_stream.handshake(wintls::handshake_type::client, std::chrono::steady_clock::now() + 10s, client_ec);
+    server_thread.join();
+    REQUIRE_FALSE(client_ec);
+    REQUIRE_FALSE(server_ec);
+
+    std::array<char, 16> buffer{};
+    error_code ec{};
+    CHECK(client_stream.read_some(net::buffer(buffer), std::chrono::steady_clock::now() + 50ms, ec) == 0);
+    CHECK(ec == net::error::timed_out);
+
+    const std::string message{"hello"};
+    CHECK(server_stream.write_some(net::buffer(message), std::chrono::steady_clock::now() + 10s) == message.size());
+
+    ec = {};
+    const auto size = client_stream.read_some(net::buffer(buffer), std::chrono::steady_clock::now() + 10s, ec);
+    REQUIRE_FALSE(ec);
+    CHECK(std::string(buffer.data(), size) == message);
+  }
+
+  SECTION("write times out") {
+    error_code server_ec{};
+    std::thread server_thread([&server_stream, &server_ec]() {
+      server_stream.handshake(wintls::handshake_type::server, server_ec);
+    });
+    error_code client_ec{};
+    client_stream.handshake(wintls::handshake_type::client, std::chrono::steady_clock::now() + 10s, client_ec);
+    server_thread.join();
+    REQUIRE_FALSE(client_ec);
+    REQUIRE_FALSE(server_ec);
+
+    // The server never reads, so the socket buffers eventually fill up
+    const std::vector<char> data(64 * 1024, 'a');
+    error_code ec{};
+    for (int i = 0; i < 1024 && !ec; ++i) {
+      client_stream.write_some(net::buffer(data), std::chrono::steady_clock::now() + 50ms, ec);
+    }
+    CHECK(ec == net::error::timed_out);
+  }
+}